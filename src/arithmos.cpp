@@ -21,62 +21,56 @@
 
 
 #include "arithmos.h"
+#include <future>
+#include <cstdint>
+#include <cerrno>
+#include <system_error>
+#if defined(__unix__) || defined(__APPLE__)
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#  define LIBARITHMOS_MMAP 1
+#else
+#  include <fstream>
+#endif
 
 namespace Arithmos {
 
 
-// useful translations
-const Translation hex_lower_to_upper{
-  Congruence{ {'a', 'A'}, 'A'}, Congruence{ {'b', 'B'}, 'B'},
-  Congruence{ {'c', 'C'}, 'C'}, Congruence{ {'d', 'D'}, 'D'},
-  Congruence{ {'e', 'E'}, 'E'}, Congruence{ {'f', 'F'}, 'F'} };
+// useful translations (each character of the first string is translated into
+// the character at the same position in the second)
+const Predefined_Translation hex_lower_to_upper{
+  "abcdefABCDEF", "ABCDEFABCDEF" };
 
-const Translation hex_upper_to_lower{
-  Congruence{ {'a', 'A'}, 'a'}, Congruence{ {'b', 'B'}, 'b'},
-  Congruence{ {'c', 'C'}, 'c'}, Congruence{ {'d', 'D'}, 'd'},
-  Congruence{ {'e', 'E'}, 'e'}, Congruence{ {'f', 'F'}, 'f'} };
+const Predefined_Translation hex_upper_to_lower{
+  "abcdefABCDEF", "abcdefabcdef" };
 
-const WTranslation whex_lower_to_upper{
-  WCongruence{ {L'a', L'A'}, L'A'}, WCongruence{ {L'b', L'B'}, L'B'},
-  WCongruence{ {L'c', L'C'}, L'C'}, WCongruence{ {L'd', L'D'}, L'D'},
-  WCongruence{ {L'e', L'E'}, L'E'}, WCongruence{ {L'f', L'F'}, L'F'} };
+const WPredefined_Translation whex_lower_to_upper{
+  L"abcdefABCDEF", L"ABCDEFABCDEF" };
 
-const WTranslation whex_upper_to_lower{
-  WCongruence{ {L'a', L'A'}, L'a'}, WCongruence{ {L'b', L'B'}, L'b'},
-  WCongruence{ {L'c', L'C'}, L'c'}, WCongruence{ {L'd', L'D'}, L'd'},
-  WCongruence{ {L'e', L'E'}, L'e'}, WCongruence{ {L'f', L'F'}, L'f'} };
+const WPredefined_Translation whex_upper_to_lower{
+  L"abcdefABCDEF", L"abcdefabcdef" };
 
 #ifdef __cpp_char8_t
-const U8Translation u8hex_lower_to_upper{
-  U8Congruence{ {u8'a', u8'A'}, u8'A'}, U8Congruence{ {u8'b', u8'B'}, u8'B'},
-  U8Congruence{ {u8'c', u8'C'}, u8'C'}, U8Congruence{ {u8'd', u8'D'}, u8'D'},
-  U8Congruence{ {u8'e', u8'E'}, u8'E'}, U8Congruence{ {u8'f', u8'F'}, u8'F'} };
-
-const U8Translation u8hex_upper_to_lower{
-  U8Congruence{ {u8'a', u8'A'}, u8'a'}, U8Congruence{ {u8'b', u8'B'}, u8'b'},
-  U8Congruence{ {u8'c', u8'C'}, u8'c'}, U8Congruence{ {u8'd', u8'D'}, u8'd'},
-  U8Congruence{ {u8'e', u8'E'}, u8'e'}, U8Congruence{ {u8'f', u8'F'}, u8'f'} };
+const U8Predefined_Translation u8hex_lower_to_upper{
+  u8"abcdefABCDEF", u8"ABCDEFABCDEF" };
+
+const U8Predefined_Translation u8hex_upper_to_lower{
+  u8"abcdefABCDEF", u8"abcdefabcdef" };
 #endif // __cpp_char8_t
 
-const U16Translation u16hex_lower_to_upper{
-  U16Congruence{ {u'a', u'A'}, u'A'}, U16Congruence{ {u'b', u'B'}, u'B'},
-  U16Congruence{ {u'c', u'C'}, u'C'}, U16Congruence{ {u'd', u'D'}, u'D'},
-  U16Congruence{ {u'e', u'E'}, u'E'}, U16Congruence{ {u'f', u'F'}, u'F'} };
+const U16Predefined_Translation u16hex_lower_to_upper{
+  u"abcdefABCDEF", u"ABCDEFABCDEF" };
 
-const U16Translation u16hex_upper_to_lower{
-  U16Congruence{ {u'a', u'A'}, u'a'}, U16Congruence{ {u'b', u'B'}, u'b'},
-  U16Congruence{ {u'c', u'C'}, u'c'}, U16Congruence{ {u'd', u'D'}, u'd'},
-  U16Congruence{ {u'e', u'E'}, u'e'}, U16Congruence{ {u'f', u'F'}, u'f'} };
+const U16Predefined_Translation u16hex_upper_to_lower{
+  u"abcdefABCDEF", u"abcdefabcdef" };
 
-const U32Translation u32hex_lower_to_upper{
-  U32Congruence{ {U'a', U'A'}, U'A'}, U32Congruence{ {U'b', U'B'}, U'B'},
-  U32Congruence{ {U'c', U'C'}, U'C'}, U32Congruence{ {U'd', U'D'}, U'D'},
-  U32Congruence{ {U'e', U'E'}, U'E'}, U32Congruence{ {U'f', U'F'}, U'F'} };
+const U32Predefined_Translation u32hex_lower_to_upper{
+  U"abcdefABCDEF", U"ABCDEFABCDEF" };
 
-const U32Translation u32hex_upper_to_lower{
-  U32Congruence{ {U'a', U'A'}, U'a'}, U32Congruence{ {U'b', U'B'}, U'b'},
-  U32Congruence{ {U'c', U'C'}, U'c'}, U32Congruence{ {U'd', U'D'}, U'd'},
-  U32Congruence{ {U'e', U'E'}, U'e'}, U32Congruence{ {U'f', U'F'}, U'f'} };
+const U32Predefined_Translation u32hex_upper_to_lower{
+  U"abcdefABCDEF", U"abcdefabcdef" };
 
 
 // invalid_format class
@@ -86,24 +80,1089 @@ const char* invalid_format::what() const noexcept {
 }
 
 
+// invalid_catalog class
+invalid_catalog::invalid_catalog() : message_{"invalid catalog"} {}
+const char* invalid_catalog::what() const noexcept {
+  return message_.c_str();
+}
+
+
+// Catalog_File class
+//
+// the file is mapped shared and read-only: its pages are shared with every
+// other process that maps the file and, being clean, can be dropped by the
+// system under memory pressure, like those of a shared library. An empty
+// file is not mapped (mmap refuses a length of zero), so data is null and
+// the catalog rejects it.
+Catalog_File::Catalog_File(const std::string& path)
+  : data_   {nullptr},
+    size_   {0},
+    mapped_ {false}
+{
+#ifdef LIBARITHMOS_MMAP
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    LIBARITHMOS_THROW(std::system_error(errno, std::generic_category(),
+                                        path));
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    const int error = errno;
+    static_cast<void>(error);  // (unused without exceptions)
+    ::close(fd);
+    LIBARITHMOS_THROW(std::system_error(error, std::generic_category(),
+                                        path));
+  }
+  size_ = static_cast<std::size_t>(st.st_size);
+  if (size_ != 0) {
+    void* p = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+      const int error = errno;
+      static_cast<void>(error);
+      ::close(fd);
+      LIBARITHMOS_THROW(std::system_error(error, std::generic_category(),
+                                          path));
+    }
+    data_ = p;
+    mapped_ = true;
+  }
+  ::close(fd);
+#else
+  std::ifstream in(path, std::ios::binary | std::ios::ate);
+  if (!in)
+    LIBARITHMOS_THROW(std::system_error(
+        std::make_error_code(std::errc::no_such_file_or_directory)));
+  const std::streamoff size = in.tellg();
+  if (size < 0)
+    LIBARITHMOS_THROW(std::system_error(
+        std::make_error_code(std::errc::io_error)));
+  size_ = static_cast<std::size_t>(size);
+  data_ = ::operator new(size_ ? size_ : 1);
+  in.seekg(0);
+  // (a short read, say of a file cut short since it was opened, is an
+  // error: the catalog is not to be read from a part of it)
+  if (!in.read(static_cast<char*>(data_), size_) ||
+      static_cast<std::size_t>(in.gcount()) != size_) {
+    ::operator delete(data_);
+    data_ = nullptr;
+    LIBARITHMOS_THROW(std::system_error(
+        std::make_error_code(std::errc::io_error)));
+  }
+#endif
+}
+
+Catalog_File::~Catalog_File() {
+#ifdef LIBARITHMOS_MMAP
+  if (mapped_)
+    ::munmap(data_, size_);
+#else
+  ::operator delete(data_);
+#endif
+}
+
+const void* Catalog_File::data() const {
+  return data_;
+}
+
+std::size_t Catalog_File::size() const {
+  return size_;
+}
+
+
+// Natural class
+//
+// The algorithms below work on plain vectors of limbs (least significant
+// first, with no most significant zero limbs), and the Natural methods
+// wrap them.
+namespace {
+
+typedef Natural::limb_type      limb_type;
+typedef std::vector<limb_type>  Limbs;
+typedef unsigned long long      dlimb_type;
+
+// numbers (in limbs) below which the schoolbook multiplication and
+// division are used, and below which a conversion is done directly
+const std::size_t karatsuba_threshold = 48;
+const std::size_t reciprocal_threshold = 64;
+const std::size_t convert_threshold = 32;
+// numbers (in limbs, or chunks of digits) below which the work is not
+// worth handing to another thread
+const std::size_t thread_threshold = 1024;
+
+void raw_trim(Limbs& a) {
+  while (!a.empty() && a.back() == 0)
+    a.pop_back();
+}
+
+Limbs raw_slice(const Limbs& a, std::size_t begin, std::size_t end) {
+  end = std::min(end, a.size());
+  Limbs s;
+  if (begin < end)
+    s.assign(a.begin() + begin, a.begin() + end);
+  raw_trim(s);
+  return s;
+}
+
+int raw_compare(const Limbs& a, const Limbs& b) {
+  if (a.size() != b.size())
+    return a.size() < b.size() ? -1 : 1;
+  for (std::size_t i = a.size(); i-- > 0; )
+    if (a[i] != b[i])
+      return a[i] < b[i] ? -1 : 1;
+  return 0;
+}
+
+// a += b x 2^(32 x shift)
+void raw_add(Limbs& a, const Limbs& b, const std::size_t shift = 0) {
+  if (b.empty())
+    return;
+  if (a.size() < b.size() + shift)
+    a.resize(b.size() + shift, 0);
+  dlimb_type carry = 0;
+  std::size_t i = shift;
+  for (std::size_t j = 0; j < b.size(); ++i, ++j) {
+    carry += dlimb_type(a[i]) + b[j];
+    a[i] = limb_type(carry);
+    carry >>= 32;
+  }
+  for (; carry && i < a.size(); ++i) {
+    carry += a[i];
+    a[i] = limb_type(carry);
+    carry >>= 32;
+  }
+  if (carry)
+    a.push_back(limb_type(carry));
+}
+
+// a -= b, where a >= b
+void raw_subtract(Limbs& a, const Limbs& b) {
+  dlimb_type borrow = 0;
+  std::size_t i = 0;
+  for (; i < b.size(); ++i) {
+    const dlimb_type d = dlimb_type(a[i]) - b[i] - borrow;
+    a[i] = limb_type(d);
+    borrow = d >> 63;
+  }
+  for (; borrow && i < a.size(); ++i) {
+    const dlimb_type d = dlimb_type(a[i]) - borrow;
+    a[i] = limb_type(d);
+    borrow = d >> 63;
+  }
+  raw_trim(a);
+}
+
+void raw_multiply_small(Limbs& a, const limb_type b, const limb_type add) {
+  dlimb_type carry = add;
+  for (auto i = a.begin(); i != a.end(); ++i) {
+    carry += dlimb_type(*i) * b;
+    *i = limb_type(carry);
+    carry >>= 32;
+  }
+  if (carry)
+    a.push_back(limb_type(carry));
+  raw_trim(a);
+}
+
+// a /= b, returning the remainder
+limb_type raw_divide_small(Limbs& a, const limb_type b) {
+  dlimb_type r = 0;
+  for (std::size_t i = a.size(); i-- > 0; ) {
+    r = (r << 32) | a[i];
+    a[i] = limb_type(r / b);
+    r %= b;
+  }
+  raw_trim(a);
+  return limb_type(r);
+}
+
+Limbs raw_multiply_schoolbook(const Limbs& a, const Limbs& b) {
+  if (a.empty() || b.empty())
+    return Limbs();
+  Limbs r(a.size() + b.size(), 0);
+  for (std::size_t i = 0; i < a.size(); ++i) {
+    dlimb_type carry = 0;
+    for (std::size_t j = 0; j < b.size(); ++j) {
+      carry += dlimb_type(a[i]) * b[j] + r[i+j];
+      r[i+j] = limb_type(carry);
+      carry >>= 32;
+    }
+    r[i + b.size()] = limb_type(carry);
+  }
+  raw_trim(r);
+  return r;
+}
+
+// run f on a thread of its own. If no thread can be started, std::async
+// throws std::system_error, which must not reach the noexcept convert: f
+// is then deferred, to run on the calling thread when its result is
+// asked for.
+template <typename F>
+auto raw_spawn(F f) -> std::future<decltype(f())> {
+#ifdef LIBARITHMOS_EXCEPTIONS
+  try {
+    return std::async(std::launch::async, f);
+  }
+  catch (const std::system_error&) {
+    return std::async(std::launch::deferred, f);
+  }
+#else
+  return std::async(std::launch::async, f);
+#endif
+}
+
+// Karatsuba's algorithm: with x = x1 B + x0 and y = y1 B + y0,
+//   x y = z2 B^2 + z1 B + z0
+// where z2 = x1 y1, z0 = x0 y0 and z1 = (x1 + x0)(y1 + y0) - z2 - z0. The
+// three products are independent, so each may be given its own thread.
+Limbs raw_multiply(const Limbs& a, const Limbs& b, const unsigned threads) {
+  const Limbs& x = a.size() >= b.size() ? a : b;
+  const Limbs& y = a.size() >= b.size() ? b : a;
+  if (y.size() < karatsuba_threshold)
+    return raw_multiply_schoolbook(x, y);
+
+  const std::size_t m = (x.size() + 1) / 2;
+  const bool spawn = threads > 1 && y.size() >= thread_threshold;
+  const Limbs x0 = raw_slice(x, 0, m);
+  const Limbs x1 = raw_slice(x, m, x.size());
+
+  if (y.size() <= m) {
+    // y is much the shorter, so just split x: x y = x1 y B + x0 y
+    const unsigned t = threads / 2;
+    std::future<Limbs> high;
+    if (spawn)
+      high = raw_spawn([&] { return raw_multiply(x1, y, t); });
+    Limbs r = raw_multiply(x0, y, spawn ? threads - t : threads);
+    raw_add(r, spawn ? high.get() : raw_multiply(x1, y, threads), m);
+    return r;
+  }
+
+  const Limbs y0 = raw_slice(y, 0, m);
+  const Limbs y1 = raw_slice(y, m, y.size());
+  Limbs sx = x0;
+  raw_add(sx, x1);
+  Limbs sy = y0;
+  raw_add(sy, y1);
+
+  // z2 and z1 are each given a third of the threads, if there are any to
+  // spare, and z0 the rest
+  unsigned left = threads;
+  const bool spawn2 = spawn && left > 1;
+  const unsigned t2 = spawn2 ? std::max(threads / 3, 1u) : threads;
+  if (spawn2)
+    left -= t2;
+  const bool spawn1 = spawn && left > 1;
+  const unsigned t1 = spawn1 ? std::max(threads / 3, 1u) : threads;
+  if (spawn1)
+    left -= t1;
+
+  std::future<Limbs> z2f, z1f;
+  if (spawn2)
+    z2f = raw_spawn([&] { return raw_multiply(x1, y1, t2); });
+  if (spawn1)
+    z1f = raw_spawn([&] { return raw_multiply(sx, sy, t1); });
+  const Limbs z0 = raw_multiply(x0, y0, left);
+  const Limbs z2 = spawn2 ? z2f.get() : raw_multiply(x1, y1, t2);
+  Limbs z1 = spawn1 ? z1f.get() : raw_multiply(sx, sy, t1);
+  raw_subtract(z1, z0);
+  raw_subtract(z1, z2);
+
+  Limbs r = z0;
+  raw_add(r, z1, m);
+  raw_add(r, z2, 2*m);
+  return r;
+}
+
+// Knuth's algorithm D (The Art of Computer Programming, vol. 2, 4.3.1)
+void raw_divide_schoolbook(const Limbs& a, const Limbs& b,
+                           Limbs& q, Limbs& r) {
+  if (raw_compare(a, b) < 0) {
+    q.clear();
+    r = a;
+    return;
+  }
+  if (b.size() == 1) {
+    q = a;
+    r.assign(1, raw_divide_small(q, b[0]));
+    raw_trim(r);
+    return;
+  }
+
+  // normalize, so the divisor's most significant limb has its top bit set
+  int shift = 0;
+  while ( !(b.back() << shift & 0x80000000u) )
+    ++shift;
+  const std::size_t n = b.size();
+  const std::size_t m = a.size() - n;
+  Limbs u(a.size() + 1, 0);
+  Limbs v(n, 0);
+  for (std::size_t i = 0; i < a.size(); ++i) {
+    u[i] |= limb_type(dlimb_type(a[i]) << shift);
+    u[i+1] = shift ? limb_type(a[i] >> (32 - shift)) : 0;
+  }
+  for (std::size_t i = 0; i < n; ++i)
+    v[i] = limb_type(dlimb_type(b[i]) << shift)
+           | (shift && i ? limb_type(b[i-1] >> (32 - shift)) : 0);
+
+  const dlimb_type base = dlimb_type(1) << 32;
+  q.assign(m + 1, 0);
+  for (std::size_t j = m + 1; j-- > 0; ) {
+    const dlimb_type top = (dlimb_type(u[j+n]) << 32) | u[j+n-1];
+    dlimb_type qhat = top / v[n-1];
+    dlimb_type rhat = top % v[n-1];
+    while ( qhat >= base ||
+            qhat * v[n-2] > ((rhat << 32) | u[j+n-2]) ) {
+      --qhat;
+      rhat += v[n-1];
+      if (rhat >= base)
+        break;
+    }
+
+    // u[j..j+n] -= qhat v
+    long long borrow = 0;
+    long long t = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+      const dlimb_type p = qhat * v[i];
+      t = (long long)u[i+j] - borrow - (long long)(p & 0xffffffffu);
+      u[i+j] = limb_type(t);
+      borrow = (long long)(p >> 32) - (t >> 32);
+    }
+    t = (long long)u[j+n] - borrow;
+    u[j+n] = limb_type(t);
+
+    // qhat was one too large (rare): add v back
+    q[j] = limb_type(qhat);
+    if (t < 0) {
+      --q[j];
+      dlimb_type carry = 0;
+      for (std::size_t i = 0; i < n; ++i) {
+        carry += dlimb_type(u[i+j]) + v[i];
+        u[i+j] = limb_type(carry);
+        carry >>= 32;
+      }
+      u[j+n] = limb_type(u[j+n] + carry);
+    }
+  }
+  raw_trim(q);
+
+  r.assign(n, 0);
+  for (std::size_t i = 0; i < n; ++i)
+    r[i] = limb_type(u[i] >> shift)
+           | (shift ? limb_type(dlimb_type(u[i+1]) << (32 - shift)) : 0);
+  raw_trim(r);
+}
+
+// 2^(32 x 2l)
+Limbs raw_power_of_two(const std::size_t l) {
+  Limbs p(2*l + 1, 0);
+  p.back() = 1;
+  return p;
+}
+
+// floor(2^(32 x 2l) / p), where p has l limbs, by Newton's method: the
+// reciprocal of the top h limbs of p (worked out recursively) is correct
+// to about h limbs, and one Newton step,
+//   x' = x + x (2^(32 x 2l) - p x) / 2^(32 x 2l),
+// doubles that. h is chosen a few limbs more than l/2 so that the result
+// is correct to within a unit or two, which the last step fixes.
+Limbs raw_reciprocal(const Limbs& p, const unsigned threads) {
+  const std::size_t l = p.size();
+  const Limbs one = raw_power_of_two(l);
+  if (l <= reciprocal_threshold) {
+    Limbs q, r;
+    raw_divide_schoolbook(one, p, q, r);
+    return q;
+  }
+
+  const std::size_t h = l/2 + 3;
+  Limbs x = raw_reciprocal(raw_slice(p, l - h, l), threads);
+  x.insert(x.begin(), l - h, 0);
+
+  Limbs t = raw_multiply(p, x, threads);
+  if (raw_compare(t, one) <= 0) {
+    Limbs e = one;
+    raw_subtract(e, t);
+    raw_add(x, raw_slice(raw_multiply(x, e, threads), 2*l, SIZE_MAX));
+  }
+  else {
+    Limbs e = t;
+    raw_subtract(e, one);
+    raw_subtract(x, raw_slice(raw_multiply(x, e, threads), 2*l, SIZE_MAX));
+  }
+
+  t = raw_multiply(p, x, threads);
+  const Limbs unit(1, 1);
+  while (raw_compare(t, one) > 0) {
+    raw_subtract(x, unit);
+    raw_subtract(t, p);
+  }
+  Limbs rem = one;
+  raw_subtract(rem, t);
+  while (raw_compare(rem, p) >= 0) {
+    raw_add(x, unit);
+    raw_subtract(rem, p);
+  }
+  return x;
+}
+
+// divide a by p, given recip = floor(2^(32 x 2l) / p) (l the limbs of p)
+// and a < 2^(32 x 2l) (Barrett's method): the estimated quotient is at
+// most two short.
+void raw_divide_reciprocal(const Limbs& a, const Limbs& p, const Limbs& recip,
+                           Limbs& q, Limbs& r, const unsigned threads) {
+  q = raw_slice(raw_multiply(a, recip, threads), 2*p.size(), SIZE_MAX);
+  r = a;
+  raw_subtract(r, raw_multiply(q, p, threads));
+  const Limbs unit(1, 1);
+  while (raw_compare(r, p) >= 0) {
+    raw_subtract(r, p);
+    raw_add(q, unit);
+  }
+}
+
+// the number of digits of a base held in each chunk (so a limb), and the
+// chunk's base: the largest power of base below 2^32
+struct Chunking {
+  explicit Chunking(const std::size_t base)
+    : base     {base},
+      digits   {1},
+      chunk    {limb_type(base)}
+  {
+    for (dlimb_type b = base; b * base <= 0xffffffffu; b *= base) {
+      ++digits;
+      chunk = limb_type(b * base);
+    }
+  }
+
+  std::size_t  base;
+  std::size_t  digits;
+  limb_type    chunk;
+};
+
+// the chunks [begin, end) (most significant first) as a number. The
+// lower 2^k chunks (the largest power of two less than end - begin) and
+// the rest are converted separately and joined with powers[k], which is
+// chunk^(2^k).
+Limbs raw_from_chunks(const Limbs& chunks, const std::size_t begin,
+                      const std::size_t end, const Chunking& c,
+                      const std::vector<Limbs>& powers,
+                      const unsigned threads) {
+  const std::size_t length = end - begin;
+  if (length <= convert_threshold) {
+    Limbs n;
+    for (std::size_t i = begin; i < end; ++i)
+      raw_multiply_small(n, c.chunk, chunks[i]);
+    return n;
+  }
+
+  std::size_t k = 0;
+  while ( (std::size_t(2) << k) < length )
+    ++k;
+  const std::size_t split = end - (std::size_t(1) << k);
+  const bool spawn = threads > 1 && length >= thread_threshold;
+  const unsigned t = spawn ? threads / 2 : threads;
+  std::future<Limbs> high;
+  if (spawn)
+    high = raw_spawn([&] { return raw_from_chunks(chunks, begin, split, c,
+                                                  powers, t); });
+  const Limbs low = raw_from_chunks(chunks, split, end, c, powers,
+                                    spawn ? threads - t : threads);
+  Limbs n = raw_multiply(spawn ? high.get()
+                               : raw_from_chunks(chunks, begin, split, c,
+                                                 powers, threads),
+                         powers[k], threads);
+  raw_add(n, low);
+  return n;
+}
+
+// write the c.digits x 2^k digits of n (which is less than
+// chunk^(2^k) = powers[k]) to out, most significant first. n is divided
+// by powers[k-1] and the quotient and remainder written separately, by
+// the reciprocal of powers[k-1] if there is one.
+void raw_to_digits(const Limbs& n, const std::size_t k,
+                   std::size_t* const out, const Chunking& c,
+                   const std::vector<Limbs>& powers,
+                   const std::vector<Limbs>& reciprocals,
+                   const unsigned threads) {
+  if (k == 0 || n.size() <= convert_threshold) {
+    Limbs t = n;
+    std::size_t position = c.digits << k;
+    while (!t.empty()) {
+      limb_type chunk = raw_divide_small(t, c.chunk);
+      for (std::size_t i = 0; i < c.digits; ++i) {
+        out[--position] = chunk % c.base;
+        chunk /= c.base;
+      }
+    }
+    return;
+  }
+
+  Limbs q, r;
+  if (reciprocals[k-1].empty())
+    raw_divide_schoolbook(n, powers[k-1], q, r);
+  else
+    raw_divide_reciprocal(n, powers[k-1], reciprocals[k-1], q, r, threads);
+
+  const bool spawn = threads > 1 && n.size() >= thread_threshold;
+  const unsigned t = spawn ? threads / 2 : threads;
+  std::future<void> high;
+  if (spawn)
+    high = raw_spawn([&] { raw_to_digits(q, k-1, out, c, powers,
+                                         reciprocals, t); });
+  raw_to_digits(r, k-1, out + (c.digits << (k-1)), c, powers, reciprocals,
+                spawn ? threads - t : threads);
+  if (spawn)
+    high.get();
+  else
+    raw_to_digits(q, k-1, out, c, powers, reciprocals, threads);
+}
+
+} // anonymous namespace
+
+Natural::Natural() : limbs_{} {}
+
+Natural::Natural(unsigned long long n) : limbs_{} {
+  while (n) {
+    limbs_.push_back(static_cast<limb_type>(n));
+    n >>= 32;
+  }
+}
+
+Natural::Natural(std::vector<limb_type> limbs) : limbs_{std::move(limbs)} {
+  raw_trim();
+}
+
+bool Natural::operator==(const Natural& n) const {
+  return limbs_ == n.limbs_;
+}
+
+bool Natural::operator!=(const Natural& n) const {
+  return !(*this == n);
+}
+
+bool Natural::operator<(const Natural& n) const {
+  return raw_compare(limbs_, n.limbs_) < 0;
+}
+
+Natural& Natural::operator+=(const limb_type n) {
+  raw_multiply_small(limbs_, 1, n);
+  return *this;
+}
+
+Natural& Natural::operator+=(const Natural& n) {
+  raw_add(limbs_, n.limbs_);
+  return *this;
+}
+
+Natural& Natural::operator-=(const Natural& n) {
+  raw_subtract(limbs_, n.limbs_);
+  return *this;
+}
+
+Natural& Natural::operator*=(const limb_type n) {
+  raw_multiply_small(limbs_, n, 0);
+  return *this;
+}
+
+Natural& Natural::operator*=(const Natural& n) {
+  limbs_ = raw_multiply(limbs_, n.limbs_, 1);
+  return *this;
+}
+
+bool Natural::is_zero() const {
+  return limbs_.empty();
+}
+
+auto Natural::limbs() const -> const std::vector<limb_type>& {
+  return limbs_;
+}
+
+Natural Natural::pow(const Natural& base, unsigned long long exponent) {
+  Natural result{1};
+  Natural square{base};
+  while (exponent) {
+    if (exponent & 1)
+      result *= square;
+    exponent >>= 1;
+    if (exponent)
+      square *= square;
+  }
+  return result;
+}
+
+Natural Natural::multiply(const Natural& a, const Natural& b,
+                          const unsigned threads) {
+  return Natural(raw_multiply(a.limbs_, b.limbs_, std::max(threads, 1u)));
+}
+
+void Natural::divide(const Natural& n, const Natural& d,
+                     Natural& quotient, Natural& remainder) {
+  if (d.is_zero())
+    LIBARITHMOS_THROW(
+        std::domain_error("Arithmos::Natural: division by zero"));
+  if (d.limbs_.size() > reciprocal_threshold &&
+      n.limbs_.size() <= 2 * d.limbs_.size())
+    raw_divide_reciprocal(n.limbs_, d.limbs_, raw_reciprocal(d.limbs_, 1),
+                          quotient.limbs_, remainder.limbs_, 1);
+  else
+    raw_divide_schoolbook(n.limbs_, d.limbs_,
+                          quotient.limbs_, remainder.limbs_);
+}
+
+Natural Natural::from_digits(const std::vector<std::size_t>& digits,
+                             const std::size_t base,
+                             const unsigned threads) {
+  const Chunking c{base};
+
+  // group the digits into chunks (the first chunk takes what is left over)
+  const std::size_t count = (digits.size() + c.digits - 1) / c.digits;
+  Limbs chunks(count, 0);
+  auto d = digits.begin();
+  for (std::size_t i = 0; i < count; ++i) {
+    std::size_t length =
+        i == 0 ? digits.size() - (count - 1) * c.digits : c.digits;
+    dlimb_type value = 0;
+    for (; length; --length)
+      value = value * base + *d++;
+    chunks[i] = limb_type(value);
+  }
+
+  // powers[k] = chunk^(2^k), for 2^k < count
+  std::vector<Limbs> powers(1, Limbs(1, c.chunk));
+  while ( (std::size_t(1) << powers.size()) < count )
+    powers.push_back(raw_multiply(powers.back(), powers.back(),
+                                  std::max(threads, 1u)));
+
+  return Natural(raw_from_chunks(chunks, 0, count, c, powers,
+                                 std::max(threads, 1u)));
+}
+
+std::vector<std::size_t> Natural::to_digits(const std::size_t base,
+                                            const unsigned threads) const {
+  std::vector<std::size_t> digits;
+  if (limbs_.empty())
+    return digits;
+  const Chunking c{base};
+  const unsigned t = std::max(threads, 1u);
+
+  // powers[k] = chunk^(2^k), up to the first that is larger than this
+  // number (which need not be worked out if its square is sure to be)
+  std::vector<Limbs> powers(1, Limbs(1, c.chunk));
+  while ( raw_compare(limbs_, powers.back()) >= 0 ) {
+    const Limbs& p = powers.back();
+    if (limbs_.size() + 1 < 2 * p.size()) {
+      powers.push_back(Limbs());
+      break;
+    }
+    powers.push_back(raw_multiply(p, p, t));
+  }
+  const std::size_t k = powers.size() - 1;
+
+  std::vector<Limbs> reciprocals(k);
+  for (std::size_t i = 0; i < k; ++i)
+    if (powers[i].size() > reciprocal_threshold)
+      reciprocals[i] = raw_reciprocal(powers[i], t);
+
+  digits.assign(c.digits << k, 0);
+  raw_to_digits(limbs_, k, digits.data(), c, powers, reciprocals, t);
+  const auto first = std::find_if(digits.begin(), digits.end(),
+                                  [](std::size_t d) { return d != 0; });
+  digits.erase(digits.begin(), first);
+  return digits;
+}
+
+void Natural::raw_trim() {
+  ::Arithmos::raw_trim(limbs_);
+}
+
+
+// Numeric_Value struct
+namespace {
+
+// hashes are taken modulo the Mersenne prime 2^61 - 1, whose residues can
+// be multiplied without a wider integer type (see raw_mulmod).
+const unsigned long long hash_prime = (1ULL << 61) - 1;
+
+unsigned long long raw_reduce(const unsigned long long n) {
+  const unsigned long long r = (n & hash_prime) + (n >> 61);
+  return r >= hash_prime ? r - hash_prime : r;
+}
+
+// a*b modulo 2^61 - 1 for a, b < 2^61 - 1: split both into 32-bit halves
+// and use 2^61 = 1 (so 2^64 = 8) to fold the partial products.
+unsigned long long raw_mulmod(const unsigned long long a,
+                              const unsigned long long b) {
+  const unsigned long long ah = a >> 32, al = a & 0xffffffff;
+  const unsigned long long bh = b >> 32, bl = b & 0xffffffff;
+  const unsigned long long mid = ah*bl + al*bh;  // < 2^62
+  const unsigned long long mid_shifted =
+        (mid >> 29) + ((mid & ((1ULL << 29) - 1)) << 32);
+  return raw_reduce(raw_reduce(ah*bh*8 + mid_shifted)
+                    + raw_reduce(al*bl));
+}
+
+unsigned long long raw_powmod(unsigned long long base,
+                              unsigned long long exponent) {
+  unsigned long long result = 1;
+  while (exponent) {
+    if (exponent & 1)
+      result = raw_mulmod(result, base);
+    base = raw_mulmod(base, base);
+    exponent >>= 1;
+  }
+  return result;
+}
+
+// the distinct prime factors of n (which is not zero)
+std::vector<std::size_t> raw_prime_factors(std::size_t n) {
+  std::vector<std::size_t> primes;
+  for (std::size_t p = 2; p <= n / p; ++p)
+    if (n % p == 0) {
+      primes.push_back(p);
+      while (n % p == 0)
+        n /= p;
+    }
+  if (n > 1)
+    primes.push_back(n);
+  return primes;
+}
+
+// the number of times the prime p divides n (which is not zero)
+unsigned long long raw_multiplicity(std::size_t n, const std::size_t p) {
+  unsigned long long multiplicity = 0;
+  for (; n % p == 0; n /= p)
+    ++multiplicity;
+  return multiplicity;
+}
+
+// divide n (which is not zero) by p as often as it can be, returning the
+// number of times: by p, p^2, p^4, ... while they divide it, then by the
+// same powers in turn from the largest, so that the divisions are by
+// numbers as long as the factor itself, however many times p divides n
+unsigned long long raw_strip(Natural& n, const std::size_t p) {
+  std::vector<Natural> powers{ Natural(p) };
+  Natural quotient, remainder;
+  unsigned long long order = 0;
+  for (;;) {
+    Natural::divide(n, powers.back(), quotient, remainder);
+    if (!remainder.is_zero())
+      break;
+    n = std::move(quotient);
+    order += 1ULL << (powers.size() - 1);
+    powers.push_back(Natural::multiply(powers.back(), powers.back()));
+  }
+  powers.pop_back();
+  while (!powers.empty()) {
+    Natural::divide(n, powers.back(), quotient, remainder);
+    if (remainder.is_zero()) {
+      n = std::move(quotient);
+      order += 1ULL << (powers.size() - 1);
+    }
+    powers.pop_back();
+  }
+  return order;
+}
+
+// an integer of any size, as a sign and a magnitude (negative zero is not
+// used)
+struct Signed {
+  bool     negative;
+  Natural  magnitude;
+
+  bool operator==(const Signed& s) const {
+    return negative == s.negative && magnitude == s.magnitude;
+  }
+};
+
+// a + b
+Signed raw_sum(Signed a, const Signed& b) {
+  if (a.negative == b.negative)
+    a.magnitude += b.magnitude;
+  else if (a.magnitude < b.magnitude) {
+    Natural m = b.magnitude;
+    m -= a.magnitude;
+    a = Signed{ b.negative, std::move(m) };
+  }
+  else
+    a.magnitude -= b.magnitude;
+  if (a.magnitude.is_zero())
+    a.negative = false;
+  return a;
+}
+
+Signed raw_signed(const width_type n) {
+  const unsigned long long magnitude = n < 0 ?
+      0ULL - static_cast<unsigned long long>(n) :
+      static_cast<unsigned long long>(n);
+  return Signed{ n < 0, Natural(magnitude) };
+}
+
+// the power of a prime p in digits x base^(exponent + scale - size):
+// stripped (the power of p in the digits) plus (exponent + scale - size) x
+// multiplicity (the power of p in the base), which need not fit in a
+// width_type
+Signed raw_power(const unsigned long long stripped,
+                 const width_type exponent, const width_type scale,
+                 const std::size_t size,
+                 const unsigned long long multiplicity) {
+  Signed k = raw_sum(raw_sum(raw_signed(exponent), raw_signed(scale)),
+                     Signed{ true, Natural(size) });
+  k.magnitude *= Natural(multiplicity);
+  if (k.magnitude.is_zero())
+    k.negative = false;
+  return raw_sum(k, Signed{ false, Natural(stripped) });
+}
+
+} // anonymous namespace
+
+Numeric_Value::Numeric_Value()
+  : is_number   {false},
+    is_zero     {false},
+    is_positive {true},
+    base        {0},
+    exponent    {0},
+    scale       {0},
+    digits      {}
+{}
+
+// The value is digits x base^(exponent + scale - digits.size()), so two
+// values of the same base are equal iff their digits and their powers
+// exponent + scale (summed as Signed, as they need not fit in a
+// width_type) are, and two values of different bases are equal iff
+//     digits1 x base1^k1 = digits2 x base2^k2.
+// As the hash depends only on the value, values with different hashes are
+// never equal. Only then is the equation checked, without working out the
+// powers (whose exponents may be as large as a width_type, and so far too
+// large to work out): each side is written as m x (the product of p^f_p),
+// for the primes p of base1 and base2 and an integer m with none of them
+// as factors, which is unique to the value. The m are found from the
+// digits alone, and the f_p are compared as integers.
+bool Numeric_Value::operator==(const Numeric_Value& v) const {
+  if (is_number != v.is_number)
+    return false;
+  if (!is_number)
+    return true;
+  if (is_zero || v.is_zero)
+    return is_zero == v.is_zero;
+  if (is_positive != v.is_positive)
+    return false;
+  if (base == v.base)
+    return digits == v.digits &&
+           raw_sum(raw_signed(exponent), raw_signed(scale)) ==
+           raw_sum(raw_signed(v.exponent), raw_signed(v.scale));
+  if (hash() != v.hash())
+    return false;
+
+  std::vector<std::size_t> primes = raw_prime_factors(base);
+  for (auto p : raw_prime_factors(v.base))
+    if (std::find(primes.begin(), primes.end(), p) == primes.end())
+      primes.push_back(p);
+  Natural lhs = Natural::from_digits(digits, base);
+  Natural rhs = Natural::from_digits(v.digits, v.base);
+  std::vector<Signed> lhs_powers, rhs_powers;
+  for (auto p : primes) {
+    lhs_powers.push_back(raw_power(raw_strip(lhs, p), exponent, scale,
+                                   digits.size(), raw_multiplicity(base, p)));
+    rhs_powers.push_back(raw_power(raw_strip(rhs, p), v.exponent, v.scale,
+                                   v.digits.size(), raw_multiplicity(v.base, p)));
+  }
+  return lhs == rhs && lhs_powers == rhs_powers;
+}
+
+bool Numeric_Value::operator!=(const Numeric_Value& v) const {
+  return !(*this == v);
+}
+
+// the hash is digits x base^(exponent + scale - digits.size()) modulo
+// 2^61 - 1, negated for negative numbers; the power is taken in two parts,
+// base^scale and base^(exponent - digits.size()), as the sum need not fit
+// in a width_type, and a negative power of base is a power of its inverse
+// (base^(p-2), by Fermat). Values that are not numbers hash to 2^61 - 1,
+// which no number does.
+std::size_t Numeric_Value::hash() const {
+  if (!is_number)
+    return static_cast<std::size_t>(hash_prime);
+  if (is_zero)
+    return 0;
+
+  const unsigned long long b = raw_reduce(base);
+  unsigned long long h = 0;
+  for (auto i = digits.begin(); i != digits.end(); ++i)
+    h = raw_reduce(raw_mulmod(h, b) + *i);
+
+  const unsigned long long inverse = raw_powmod(b, hash_prime-2);
+  for (const width_type k :
+          { scale, exponent - static_cast<width_type>(digits.size()) }) {
+    if (k >= 0)
+      h = raw_mulmod(h, raw_powmod(b, k));
+    else
+      h = raw_mulmod(h, raw_powmod(inverse,
+                                   0ULL - static_cast<unsigned long long>(k)));
+  }
+  if (!is_positive && h)
+    h = hash_prime - h;
+  return static_cast<std::size_t>(h);
+}
+
+
+// Byte_Automaton struct
+const std::uint32_t Byte_Automaton::version;
+
+namespace {
+
+void raw_put_word(std::string& s, const std::uint32_t w) {
+  for (int i = 0; i < 4; ++i)
+    s += static_cast<char>((w >> (8*i)) & 0xff);
+}
+
+std::uint32_t raw_get_word(const std::string& s, const std::size_t at) {
+  std::uint32_t w = 0;
+  for (int i = 3; i >= 0; --i)
+    w = (w << 8) | static_cast<unsigned char>(s[at + i]);
+  return w;
+}
+
+} // anonymous namespace
+
+Byte_Automaton::Byte_Automaton()
+  : class_count {0},
+    dead        {0},
+    exact       {true},
+    classes     {},
+    accepting   {},
+    transitions {}
+{}
+
+bool Byte_Automaton::matches(const char* first, const char* last) const {
+  if (accepting.empty())
+    return false;
+  std::uint32_t state = 0;
+  for (; first != last && state != dead; ++first)
+    state = transitions[state * class_count
+                        + classes[static_cast<unsigned char>(*first)]];
+  return accepting[state] != 0;
+}
+
+bool Byte_Automaton::matches(const std::string& s) const {
+  return matches(s.data(), s.data() + s.size());
+}
+
+std::string Byte_Automaton::serialize() const {
+  std::string s("ADFA");
+  raw_put_word(s, version);
+  raw_put_word(s, class_count);
+  raw_put_word(s, static_cast<std::uint32_t>(accepting.size()));
+  raw_put_word(s, dead);
+  raw_put_word(s, exact ? 1 : 0);
+  for (auto c : classes)
+    s += static_cast<char>(c);
+  for (auto a : accepting)
+    s += static_cast<char>(a);
+  s.append((4 - accepting.size() % 4) % 4, '\0');
+  for (auto t : transitions)
+    raw_put_word(s, t);
+  return s;
+}
+
+// every field is checked, so that a block that deserializes can be scanned
+// without going out of bounds
+bool Byte_Automaton::deserialize(const std::string& s, Byte_Automaton& a) {
+  const std::size_t header = 24;
+  if (s.size() < header || s.compare(0, 4, "ADFA") != 0 ||
+      raw_get_word(s, 4) != version)
+    return false;
+  const std::uint64_t classes = raw_get_word(s, 8);
+  const std::uint64_t states = raw_get_word(s, 12);
+  const std::uint32_t dead = raw_get_word(s, 16);
+  const std::uint32_t exact = raw_get_word(s, 20);
+  const std::uint64_t padded = (states + 3) / 4 * 4;
+  if (classes > 256 || exact > 1 || (states && dead >= states) ||
+      s.size() != header + 256 + padded + 4 * states * classes)
+    return false;
+
+  Byte_Automaton b;
+  b.class_count = static_cast<std::uint32_t>(classes);
+  b.dead = dead;
+  b.exact = exact;
+  std::size_t at = header;
+  for (; at < header + 256; ++at) {
+    b.classes.push_back(static_cast<unsigned char>(s[at]));
+    if (states && b.classes.back() >= classes)
+      return false;
+  }
+  for (std::uint64_t i = 0; i < states; ++i, ++at)
+    b.accepting.push_back(static_cast<unsigned char>(s[at]));
+  at = header + 256 + padded;
+  for (std::uint64_t i = 0; i < states * classes; ++i, at += 4) {
+    b.transitions.push_back(raw_get_word(s, at));
+    if (b.transitions.back() >= states)
+      return false;
+  }
+  a = std::move(b);
+  return true;
+}
+
+
+// Intern_Table class
+const Intern_Table::id_type Intern_Table::npos;
+
+std::size_t Intern_Table::Hash::operator()(const Numeric_Value& v) const {
+  return v.hash();
+}
+
+auto Intern_Table::intern(const Numeric_Value& v) -> id_type {
+  if (!v.is_number)
+    return npos;
+  const auto i = ids_.emplace(v, values_.size());
+  if (i.second)
+    values_.push_back(&i.first->first);
+  return i.first->second;
+}
+
+auto Intern_Table::find(const Numeric_Value& v) const -> id_type {
+  const auto i = ids_.find(v);
+  return i == ids_.end() ? npos : i->second;
+}
+
+const Numeric_Value& Intern_Table::operator[](const id_type id) const {
+  return *values_[id];
+}
+
+std::size_t Intern_Table::size() const {
+  return values_.size();
+}
+
+void Intern_Table::clear() {
+  ids_.clear();
+  values_.clear();
+}
+
+
+// The digit lists and formats below are all constant-initialized: the
+// digits are held in static arrays (given internal linkage here, and
+// exported through the Predefined_Digits views), and the Basic_Format
+// objects are only built when they are first used (see the class
+// Basic_Predefined_Format in arithmos.h).
+
+
 // useful lists for defining number Formats
-const std::vector<Format::digit_type> binary_digits{
+namespace {
+
+const Format::digit_type binary_digit_list[]{
   Format::digit_type{'0'}, Format::digit_type{'1'} };
 
-const std::vector<Format::digit_type> octal_digits{
+const Format::digit_type octal_digit_list[]{
   Format::digit_type{'0'}, Format::digit_type{'1'},
   Format::digit_type{'2'}, Format::digit_type{'3'},
   Format::digit_type{'4'}, Format::digit_type{'5'},
   Format::digit_type{'6'}, Format::digit_type{'7'} };
 
-const std::vector<Format::digit_type> decimal_digits{
+const Format::digit_type decimal_digit_list[]{
   Format::digit_type{'0'}, Format::digit_type{'1'},
   Format::digit_type{'2'}, Format::digit_type{'3'},
   Format::digit_type{'4'}, Format::digit_type{'5'},
   Format::digit_type{'6'}, Format::digit_type{'7'},
   Format::digit_type{'8'}, Format::digit_type{'9'} };
 
-const std::vector<Format::digit_type> hexadecimal_digits{
+const Format::digit_type hexadecimal_digit_list[]{
   Format::digit_type{'0'}, Format::digit_type{'1'},
   Format::digit_type{'2'}, Format::digit_type{'3'},
   Format::digit_type{'4'}, Format::digit_type{'5'},
@@ -113,43 +1172,55 @@ const std::vector<Format::digit_type> hexadecimal_digits{
   Format::digit_type{'c'}, Format::digit_type{'d'},
   Format::digit_type{'e'}, Format::digit_type{'f'} };
 
+} // anonymous namespace
+
+const Predefined_Digits binary_digits{ binary_digit_list };
+const Predefined_Digits octal_digits{ octal_digit_list };
+const Predefined_Digits decimal_digits{ decimal_digit_list };
+const Predefined_Digits hexadecimal_digits{ hexadecimal_digit_list };
+
 
 // declare a binary-format number.
-const Format  binary{ "0b", binary_digits, "e", decimal_digits };
+const Predefined_Format  binary{ "0b", binary_digit_list, "e",
+                                 decimal_digit_list };
 
 
 // declare an octal-format number.
-const Format  octal{ "0", octal_digits, "e", decimal_digits };
+const Predefined_Format  octal{ "0", octal_digit_list, "e",
+                                decimal_digit_list };
 
 
 // declare a decimal-format number.
-const Format  decimal{ "", decimal_digits, "e", decimal_digits };
+const Predefined_Format  decimal{ "", decimal_digit_list, "e",
+                                  decimal_digit_list };
 
 
 // declare a hexadecimal-format number.
-const Format  hexadecimal{ "0x", hexadecimal_digits, "p", decimal_digits };
-
+const Predefined_Format  hexadecimal{ "0x", hexadecimal_digit_list, "p",
+                                      decimal_digit_list };
 
 
 // wchar_t versions:
 // useful lists for defining number Formats
-const std::vector<WFormat::digit_type> wbinary_digits{
+namespace {
+
+const WFormat::digit_type wbinary_digit_list[]{
   WFormat::digit_type{L'0'}, WFormat::digit_type{L'1'} };
 
-const std::vector<WFormat::digit_type> woctal_digits{
+const WFormat::digit_type woctal_digit_list[]{
   WFormat::digit_type{L'0'}, WFormat::digit_type{L'1'},
   WFormat::digit_type{L'2'}, WFormat::digit_type{L'3'},
   WFormat::digit_type{L'4'}, WFormat::digit_type{L'5'},
   WFormat::digit_type{L'6'}, WFormat::digit_type{L'7'} };
 
-const std::vector<WFormat::digit_type> wdecimal_digits{
+const WFormat::digit_type wdecimal_digit_list[]{
   WFormat::digit_type{L'0'}, WFormat::digit_type{L'1'},
   WFormat::digit_type{L'2'}, WFormat::digit_type{L'3'},
   WFormat::digit_type{L'4'}, WFormat::digit_type{L'5'},
   WFormat::digit_type{L'6'}, WFormat::digit_type{L'7'},
   WFormat::digit_type{L'8'}, WFormat::digit_type{L'9'} };
 
-const std::vector<WFormat::digit_type> whexadecimal_digits{
+const WFormat::digit_type whexadecimal_digit_list[]{
   WFormat::digit_type{L'0'}, WFormat::digit_type{L'1'},
   WFormat::digit_type{L'2'}, WFormat::digit_type{L'3'},
   WFormat::digit_type{L'4'}, WFormat::digit_type{L'5'},
@@ -159,44 +1230,56 @@ const std::vector<WFormat::digit_type> whexadecimal_digits{
   WFormat::digit_type{L'c'}, WFormat::digit_type{L'd'},
   WFormat::digit_type{L'e'}, WFormat::digit_type{L'f'} };
 
+} // anonymous namespace
+
+const WPredefined_Digits wbinary_digits{ wbinary_digit_list };
+const WPredefined_Digits woctal_digits{ woctal_digit_list };
+const WPredefined_Digits wdecimal_digits{ wdecimal_digit_list };
+const WPredefined_Digits whexadecimal_digits{ whexadecimal_digit_list };
+
 
 // declare a binary-format number.
-const WFormat  wbinary{ L"0b", wbinary_digits, L"e", wdecimal_digits };
+const WPredefined_Format  wbinary{ L"0b", wbinary_digit_list, L"e",
+                                   wdecimal_digit_list };
 
 
 // declare an octal-format number.
-const WFormat  woctal{ L"0", woctal_digits, L"e", wdecimal_digits };
+const WPredefined_Format  woctal{ L"0", woctal_digit_list, L"e",
+                                  wdecimal_digit_list };
 
 
 // declare a decimal-format number.
-const WFormat  wdecimal{ L"", wdecimal_digits, L"e", wdecimal_digits };
+const WPredefined_Format  wdecimal{ L"", wdecimal_digit_list, L"e",
+                                    wdecimal_digit_list };
 
 
 // declare a hexadecimal-format number.
-const WFormat  whexadecimal{ L"0x", whexadecimal_digits, L"p", wdecimal_digits };
-
-
+const WPredefined_Format  whexadecimal{ L"0x", whexadecimal_digit_list, L"p",
+                                        wdecimal_digit_list };
 
 #ifdef __cpp_char8_t
+
 // char8_t versions:
 // useful lists for defining number Formats
-const std::vector<U8Format::digit_type> u8binary_digits{
+namespace {
+
+const U8Format::digit_type u8binary_digit_list[]{
   U8Format::digit_type{u8'0'}, U8Format::digit_type{u8'1'} };
 
-const std::vector<Format::digit_type> u8octal_digits{
+const U8Format::digit_type u8octal_digit_list[]{
   U8Format::digit_type{u8'0'}, U8Format::digit_type{u8'1'},
   U8Format::digit_type{u8'2'}, U8Format::digit_type{u8'3'},
   U8Format::digit_type{u8'4'}, U8Format::digit_type{u8'5'},
   U8Format::digit_type{u8'6'}, U8Format::digit_type{u8'7'} };
 
-const std::vector<Format::digit_type> u8decimal_digits{
+const U8Format::digit_type u8decimal_digit_list[]{
   U8Format::digit_type{u8'0'}, U8Format::digit_type{u8'1'},
   U8Format::digit_type{u8'2'}, U8Format::digit_type{u8'3'},
   U8Format::digit_type{u8'4'}, U8Format::digit_type{u8'5'},
   U8Format::digit_type{u8'6'}, U8Format::digit_type{u8'7'},
   U8Format::digit_type{u8'8'}, U8Format::digit_type{u8'9'} };
 
-const std::vector<Format::digit_type> u8hexadecimal_digits{
+const U8Format::digit_type u8hexadecimal_digit_list[]{
   U8Format::digit_type{u8'0'}, U8Format::digit_type{u8'1'},
   U8Format::digit_type{u8'2'}, U8Format::digit_type{u8'3'},
   U8Format::digit_type{u8'4'}, U8Format::digit_type{u8'5'},
@@ -206,44 +1289,56 @@ const std::vector<Format::digit_type> u8hexadecimal_digits{
   U8Format::digit_type{u8'c'}, U8Format::digit_type{u8'd'},
   U8Format::digit_type{u8'e'}, U8Format::digit_type{u8'f'} };
 
+} // anonymous namespace
+
+const U8Predefined_Digits u8binary_digits{ u8binary_digit_list };
+const U8Predefined_Digits u8octal_digits{ u8octal_digit_list };
+const U8Predefined_Digits u8decimal_digits{ u8decimal_digit_list };
+const U8Predefined_Digits u8hexadecimal_digits{ u8hexadecimal_digit_list };
+
 
 // declare a binary-format number.
-const U8Format  u8binary{ u8"0b", u8binary_digits, u8"e", u8decimal_digits };
+const U8Predefined_Format  u8binary{ u8"0b", u8binary_digit_list, u8"e",
+                                     u8decimal_digit_list };
 
 
 // declare an octal-format number.
-const U8Format  u8octal{ u8"0", u8octal_digits, u8"e", u8decimal_digits };
+const U8Predefined_Format  u8octal{ u8"0", u8octal_digit_list, u8"e",
+                                    u8decimal_digit_list };
 
 
 // declare a decimal-format number.
-const U8Format  u8decimal{ u8"", u8decimal_digits, u8"e", u8decimal_digits };
+const U8Predefined_Format  u8decimal{ u8"", u8decimal_digit_list, u8"e",
+                                      u8decimal_digit_list };
 
 
 // declare a hexadecimal-format number.
-const U8Format  u8hexadecimal{ u8"0x", u8hexadecimal_digits, u8"p", u8decimal_digits };
-#endif // __cpp_char16_t
-
+const U8Predefined_Format  u8hexadecimal{ u8"0x", u8hexadecimal_digit_list, u8"p",
+                                          u8decimal_digit_list };
+#endif // __cpp_char8_t
 
 
 // char16_t versions:
 // useful lists for defining number Formats
-const std::vector<U16Format::digit_type> u16binary_digits{
+namespace {
+
+const U16Format::digit_type u16binary_digit_list[]{
   U16Format::digit_type{u'0'}, U16Format::digit_type{u'1'} };
 
-const std::vector<U16Format::digit_type> u16octal_digits{
+const U16Format::digit_type u16octal_digit_list[]{
   U16Format::digit_type{u'0'}, U16Format::digit_type{u'1'},
   U16Format::digit_type{u'2'}, U16Format::digit_type{u'3'},
   U16Format::digit_type{u'4'}, U16Format::digit_type{u'5'},
   U16Format::digit_type{u'6'}, U16Format::digit_type{u'7'} };
 
-const std::vector<U16Format::digit_type> u16decimal_digits{
+const U16Format::digit_type u16decimal_digit_list[]{
   U16Format::digit_type{u'0'}, U16Format::digit_type{u'1'},
   U16Format::digit_type{u'2'}, U16Format::digit_type{u'3'},
   U16Format::digit_type{u'4'}, U16Format::digit_type{u'5'},
   U16Format::digit_type{u'6'}, U16Format::digit_type{u'7'},
   U16Format::digit_type{u'8'}, U16Format::digit_type{u'9'} };
 
-const std::vector<U16Format::digit_type> u16hexadecimal_digits{
+const U16Format::digit_type u16hexadecimal_digit_list[]{
   U16Format::digit_type{u'0'}, U16Format::digit_type{u'1'},
   U16Format::digit_type{u'2'}, U16Format::digit_type{u'3'},
   U16Format::digit_type{u'4'}, U16Format::digit_type{u'5'},
@@ -253,43 +1348,55 @@ const std::vector<U16Format::digit_type> u16hexadecimal_digits{
   U16Format::digit_type{u'c'}, U16Format::digit_type{u'd'},
   U16Format::digit_type{u'e'}, U16Format::digit_type{u'f'} };
 
+} // anonymous namespace
+
+const U16Predefined_Digits u16binary_digits{ u16binary_digit_list };
+const U16Predefined_Digits u16octal_digits{ u16octal_digit_list };
+const U16Predefined_Digits u16decimal_digits{ u16decimal_digit_list };
+const U16Predefined_Digits u16hexadecimal_digits{ u16hexadecimal_digit_list };
+
 
 // declare a binary-format number.
-const U16Format  u16binary{ u"0b", u16binary_digits, u"e", u16decimal_digits };
+const U16Predefined_Format  u16binary{ u"0b", u16binary_digit_list, u"e",
+                                       u16decimal_digit_list };
 
 
 // declare an octal-format number.
-const U16Format  u16octal{ u"0", u16octal_digits, u"e", u16decimal_digits };
+const U16Predefined_Format  u16octal{ u"0", u16octal_digit_list, u"e",
+                                      u16decimal_digit_list };
 
 
 // declare a decimal-format number.
-const U16Format  u16decimal{ u"", u16decimal_digits, u"e", u16decimal_digits };
+const U16Predefined_Format  u16decimal{ u"", u16decimal_digit_list, u"e",
+                                        u16decimal_digit_list };
 
 
 // declare a hexadecimal-format number.
-const U16Format  u16hexadecimal{ u"0x", u16hexadecimal_digits, u"p", u16decimal_digits };
-
+const U16Predefined_Format  u16hexadecimal{ u"0x", u16hexadecimal_digit_list, u"p",
+                                            u16decimal_digit_list };
 
 
 // char32_t versions:
-// useful lists for defining number U32Formats
-const std::vector<U32Format::digit_type> u32binary_digits{
+// useful lists for defining number Formats
+namespace {
+
+const U32Format::digit_type u32binary_digit_list[]{
   U32Format::digit_type{U'0'}, U32Format::digit_type{U'1'} };
 
-const std::vector<U32Format::digit_type> u32octal_digits{
+const U32Format::digit_type u32octal_digit_list[]{
   U32Format::digit_type{U'0'}, U32Format::digit_type{U'1'},
   U32Format::digit_type{U'2'}, U32Format::digit_type{U'3'},
   U32Format::digit_type{U'4'}, U32Format::digit_type{U'5'},
   U32Format::digit_type{U'6'}, U32Format::digit_type{U'7'} };
 
-const std::vector<U32Format::digit_type> u32decimal_digits{
+const U32Format::digit_type u32decimal_digit_list[]{
   U32Format::digit_type{U'0'}, U32Format::digit_type{U'1'},
   U32Format::digit_type{U'2'}, U32Format::digit_type{U'3'},
   U32Format::digit_type{U'4'}, U32Format::digit_type{U'5'},
   U32Format::digit_type{U'6'}, U32Format::digit_type{U'7'},
   U32Format::digit_type{U'8'}, U32Format::digit_type{U'9'} };
 
-const std::vector<U32Format::digit_type> u32hexadecimal_digits{
+const U32Format::digit_type u32hexadecimal_digit_list[]{
   U32Format::digit_type{U'0'}, U32Format::digit_type{U'1'},
   U32Format::digit_type{U'2'}, U32Format::digit_type{U'3'},
   U32Format::digit_type{U'4'}, U32Format::digit_type{U'5'},
@@ -299,51 +1406,98 @@ const std::vector<U32Format::digit_type> u32hexadecimal_digits{
   U32Format::digit_type{U'c'}, U32Format::digit_type{U'd'},
   U32Format::digit_type{U'e'}, U32Format::digit_type{U'f'} };
 
+} // anonymous namespace
+
+const U32Predefined_Digits u32binary_digits{ u32binary_digit_list };
+const U32Predefined_Digits u32octal_digits{ u32octal_digit_list };
+const U32Predefined_Digits u32decimal_digits{ u32decimal_digit_list };
+const U32Predefined_Digits u32hexadecimal_digits{ u32hexadecimal_digit_list };
+
 
 // declare a binary-format number.
-const U32Format  u32binary{ U"0b", u32binary_digits, U"e", u32decimal_digits };
+const U32Predefined_Format  u32binary{ U"0b", u32binary_digit_list, U"e",
+                                       u32decimal_digit_list };
 
 
 // declare an octal-format number.
-const U32Format  u32octal{ U"0", u32octal_digits, U"e", u32decimal_digits };
+const U32Predefined_Format  u32octal{ U"0", u32octal_digit_list, U"e",
+                                      u32decimal_digit_list };
 
 
 // declare a decimal-format number.
-const U32Format  u32decimal{ U"", u32decimal_digits, U"e", u32decimal_digits };
+const U32Predefined_Format  u32decimal{ U"", u32decimal_digit_list, U"e",
+                                        u32decimal_digit_list };
 
 
 // declare a hexadecimal-format number.
-const U32Format  u32hexadecimal{ U"0x", u32hexadecimal_digits, U"p", u32decimal_digits };
+const U32Predefined_Format  u32hexadecimal{ U"0x", u32hexadecimal_digit_list, U"p",
+                                            u32decimal_digit_list };
 
 
 
-// also, let's create some explicit instantiations of the templated classes:
+// also, let's create some explicit instantiations of the templated classes
+// (these are declared `extern template' in arithmos.h, so this is the only
+// copy of them that programs using the library will link to):
 template class  Basic_Congruence<char>;
 template class  Basic_Digit<char, count_type>;
 template class  Basic_Format<char, count_type>;
 template struct Basic_Data<char>;
+template struct Basic_Batch<char>;
+template class  Basic_Cached_Format<char, count_type>;
+template class  Basic_Numeric_Less<char, count_type>;
+template class  Basic_Format_Registry<char, count_type>;
+template class  Basic_Catalog<char, count_type>;
+template class  Basic_Push_Parser<char, count_type>;
 
 template class  Basic_Congruence<wchar_t>;
 template class  Basic_Digit<wchar_t, count_type>;
 template class  Basic_Format<wchar_t, count_type>;
 template struct Basic_Data<wchar_t>;
+template struct Basic_Batch<wchar_t>;
+template class  Basic_Cached_Format<wchar_t, count_type>;
+template class  Basic_Numeric_Less<wchar_t, count_type>;
+template class  Basic_Format_Registry<wchar_t, count_type>;
+template class  Basic_Catalog<wchar_t, count_type>;
+template class  Basic_Push_Parser<wchar_t, count_type>;
 
 #ifdef __cpp_char8_t
 template class  Basic_Congruence<char8_t>;
 template class  Basic_Digit<char8_t, count_type>;
 template class  Basic_Format<char8_t, count_type>;
 template struct Basic_Data<char8_t>;
+template struct Basic_Batch<char8_t>;
+template class  Basic_Cached_Format<char8_t, count_type>;
+template class  Basic_Numeric_Less<char8_t, count_type>;
+template class  Basic_Format_Registry<char8_t, count_type>;
+template class  Basic_Catalog<char8_t, count_type>;
+template class  Basic_Push_Parser<char8_t, count_type>;
 #endif // __cpp_char8_t
 
 template class  Basic_Congruence<char16_t>;
 template class  Basic_Digit<char16_t, count_type>;
 template class  Basic_Format<char16_t, count_type>;
 template struct Basic_Data<char16_t>;
+template struct Basic_Batch<char16_t>;
+template class  Basic_Cached_Format<char16_t, count_type>;
+template class  Basic_Numeric_Less<char16_t, count_type>;
+template class  Basic_Format_Registry<char16_t, count_type>;
+template class  Basic_Catalog<char16_t, count_type>;
+template class  Basic_Push_Parser<char16_t, count_type>;
 
 template class  Basic_Congruence<char32_t>;
 template class  Basic_Digit<char32_t, count_type>;
 template class  Basic_Format<char32_t, count_type>;
 template struct Basic_Data<char32_t>;
+template struct Basic_Batch<char32_t>;
+template class  Basic_Cached_Format<char32_t, count_type>;
+template class  Basic_Numeric_Less<char32_t, count_type>;
+template class  Basic_Format_Registry<char32_t, count_type>;
+template class  Basic_Catalog<char32_t, count_type>;
+template class  Basic_Push_Parser<char32_t, count_type>;
+
+template struct Column<std::int64_t>;
+template struct Column<std::uint64_t>;
+template struct Column<double>;
 
 
 template std::basic_string<char> translate(
@@ -27,14 +27,39 @@
 #define LIBARITHMOS_H
 
 #include <string>
-#include <sstream>
-#include <iostream>
 #include <vector>
 #include <exception>
 #include <cmath>
 #include <unordered_set>
 #include <stdexcept>
 #include <type_traits>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <memory>
+#include <unordered_map>
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <functional>
+#include <thread>
+#include <cstdlib>
+#include <cstring>
+
+
+// the library may be built, and used, without exceptions (as with
+// -fno-exceptions): the errors that it would otherwise throw then abort the
+// program, and the noexcept methods (Basic_Format::parse and convert, and
+// the validate functions) can be used to find errors without raising them.
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS)
+#  define LIBARITHMOS_EXCEPTIONS 1
+#  define LIBARITHMOS_THROW(e)  throw e
+#else
+#  define LIBARITHMOS_THROW(e)  std::abort()
+#endif
 
 
 namespace Arithmos {
@@ -51,6 +76,129 @@ typedef long long int       width_type;
 
 
 
+/** enum class errc
+ *
+ * the reasons that the noexcept methods give for a failure:
+ *   ok                    - no error
+ *   empty                 - the string is empty
+ *   specifier             - the string does not start with the format's
+ *                           specifier (after any sign)
+ *   digit                 - a character is not one of the format's digits
+ *   digit_count           - a digit is used more times than it may be
+ *   lone_point            - the digits are just a decimal point
+ *   no_digits             - there are no digits (and no exponent)
+ *   no_exponent_digits    - the exponent string is not followed by digits
+ *   exponent_digit        - a character in the exponent is not one of the
+ *                           format's exponent digits
+ *   exponent_digit_count  - an exponent digit is used more times than it
+ *                           may be
+ *   not_integer           - the number converted is not an integer literal
+ *   invalid_format        - a format cannot be made from the digits given
+ *                           (see invalid_format)
+ *   not_in_set            - a congruence's default is not in its set (see
+ *                           congruence_not_in_set)
+ *   separator             - a digit-group separator is misplaced, or a
+ *                           group of digits has the wrong width (the
+ *                           position is that of the separator, or of the
+ *                           end of the group)
+ *   catalog               - a block of memory is not a catalog of formats
+ *                           for the character and counter types (see
+ *                           invalid_catalog)
+ *   length_limit          - the string is longer than the limit (the
+ *                           position is the limit; see Basic_Format::Limits)
+ *   digit_limit           - the number has more significant digits than the
+ *                           limit (at the first digit over it)
+ *   exponent_limit        - the exponent's magnitude is over the limit (at
+ *                           the exponent digit that takes it over)
+ *   cost_limit            - converting the number would cost more than the
+ *                           limit (the position is 0)
+ *
+ */
+enum class errc {
+  ok = 0,
+  empty,
+  specifier,
+  digit,
+  digit_count,
+  lone_point,
+  no_digits,
+  no_exponent_digits,
+  exponent_digit,
+  exponent_digit_count,
+  not_integer,
+  invalid_format,
+  not_in_set,
+  separator,
+  catalog,
+  length_limit,
+  digit_limit,
+  exponent_limit,
+  cost_limit
+};
+
+
+
+/** struct Status
+ *
+ * the result of a noexcept method: the error (errc::ok if there was none)
+ * and the position in the input of the first character that could not be
+ * accepted (or the length of the input, if something is missing from its
+ * end or there was no error). The struct converts to true if there was no
+ * error.
+ *
+ */
+struct Status {
+  errc         error;
+  std::size_t  position;
+
+  explicit operator bool() const noexcept { return error == errc::ok; }
+};
+
+
+
+/** enum class Rounding
+ *
+ * how Basic_Format::round and round_places round a number that lies
+ * between two candidates:
+ *   nearest_even     - to the nearer, and ties to the one whose last kept
+ *                      digit is even
+ *   nearest_away     - to the nearer, and ties away from zero
+ *   toward_zero      - to the one nearer zero (truncation)
+ *   away_from_zero   - to the one further from zero
+ *   toward_positive  - to the larger (the ceiling)
+ *   toward_negative  - to the smaller (the floor)
+ *
+ * Note: in an odd base, no number with finitely many digits lies exactly
+ * half-way between two candidates, so there are no ties to break.
+ *
+ */
+enum class Rounding {
+  nearest_even,
+  nearest_away,
+  toward_zero,
+  away_from_zero,
+  toward_positive,
+  toward_negative
+};
+
+
+
+/** enum class Syntax
+ *
+ * the syntax of a regular expression made by Basic_Format::pattern:
+ *   posix       - a POSIX extended regular expression (as grep -E and
+ *                 std::regex::extended read)
+ *   ecmascript  - an ECMAScript regular expression (as JavaScript and
+ *                 std::regex read by default)
+ *
+ */
+enum class Syntax {
+  posix,
+  ecmascript
+};
+
+
+
 /** class congruence_not_in_set  (public std::out_of_range)
  *
  * thrown by the Basic_Congruence constructor if the default element is not
@@ -91,6 +239,10 @@ private:
 public:
   Basic_Congruence(const set&, const char_type);
 
+  // return errc::not_in_set if the constructor would throw with these
+  // arguments, or errc::ok otherwise
+  static errc validate(const set&, const char_type) noexcept;
+
   bool operator==(const Basic_Congruence&) const;
   bool operator!=(const Basic_Congruence&) const;
 
@@ -106,6 +258,8 @@ public:
     //    normalize('b')  -> returns 'b'
   bool       has(const char_type) const;
     // return true if argument is in set_ and false otherwise.
+  const set& get_set() const;
+    // return the set of elements (i.e., set_).
 };
 
 
@@ -159,6 +313,21 @@ public:
 
 
 
+/** class invalid_catalog  (public std::exception)
+ *
+ * thrown by the Basic_Catalog class ctor if the block of memory it is
+ * given is not a valid catalog (see Basic_Catalog::validate).
+ *
+ */
+class invalid_catalog : public std::exception {
+  std::string message_;
+public:
+  invalid_catalog();
+  const char* what() const noexcept;
+};
+
+
+
 /** class Basic_Digit
  *
  * class specifies a digit and a counter that can be set to how many times
@@ -177,9 +346,10 @@ private:
   count_type  count_max_; // the max number of times that the character
                           // can be used
 public:
-  // ctors
-  Basic_Digit(const char_type, const count_type);
-  Basic_Digit(const char_type);
+  // ctors (constexpr, so that static tables of digits are initialized at
+  // compile time)
+  constexpr Basic_Digit(const char_type, const count_type);
+  constexpr Basic_Digit(const char_type);
 
   // some operator overloads
   bool operator==(const Basic_Digit&) const;
@@ -187,8 +357,50 @@ public:
   bool operator!=(const Basic_Digit&) const;
   bool operator!=(const char_type) const;
 
-  char_type   name() const;      // get the digit symbol
-  count_type  count_max() const; // get the max counter value
+  constexpr char_type   name() const;      // get the digit symbol
+  constexpr count_type  count_max() const; // get the max counter value
+};
+
+
+
+/** class Basic_Predefined_Digits
+ *
+ * class is a view over a static array of Basic_Digit objects. It can be
+ * constant-initialized, so the library's pre-defined digit lists (e.g.,
+ * Arithmos::decimal_digits) cost nothing at program start-up. A copy of
+ * the digits can be taken as a std::vector, which is what is needed to
+ * define a Basic_Format with them:
+ *
+ *   Format number{ "0d", decimal_digits, "e", decimal_digits };
+ *
+ */
+template <typename TChar, typename TCounter = count_type>
+class Basic_Predefined_Digits {
+public:
+  typedef Basic_Digit<TChar,TCounter>  digit_type;
+  typedef std::vector<digit_type>      digits_type;
+  typedef const digit_type*            const_iterator;
+  typedef std::size_t                  size_type;
+
+private:
+  const digit_type*  digits_;  // the first digit of the static array
+  size_type          size_;    // the number of digits in the array
+
+public:
+  // ctor
+  template <size_type N>
+  constexpr Basic_Predefined_Digits(const digit_type (&)[N]);
+  // ctor: a view over the given number of digits held elsewhere (as in a
+  // Basic_Catalog)
+  constexpr Basic_Predefined_Digits(const digit_type*, const size_type);
+
+  const_iterator     begin() const;
+  const_iterator     end() const;
+  size_type          size() const;
+  const digit_type&  operator[](const size_type) const;
+
+  // return a copy of the digits
+  operator digits_type() const;
 };
 
 
@@ -208,6 +420,8 @@ struct Basic_Data {
 
   // ctor
   Basic_Data();
+  // reset to a default Basic_Data, keeping the capacity of the strings
+  void clear();
   // overload == operator
   bool operator==(const Basic_Data&) const;
   // overload != operator
@@ -286,6 +500,259 @@ struct Basic_Data {
 
 
 
+/** class Natural
+ *
+ * class records an unsigned integer of any size, as a vector of 32-bit
+ * limbs (least significant first). It gives the library exact arithmetic
+ * on numbers that are too large for the native integer types.
+ *
+ */
+class Natural {
+public:
+  typedef std::uint32_t  limb_type;
+
+private:
+  std::vector<limb_type>  limbs_;   // no most significant zero limbs
+
+public:
+  // ctors
+  Natural();
+  Natural(unsigned long long);
+  explicit Natural(std::vector<limb_type>);  // least significant first
+
+  bool operator==(const Natural&) const;
+  bool operator!=(const Natural&) const;
+  bool operator<(const Natural&) const;
+
+  Natural& operator+=(const limb_type);
+  Natural& operator+=(const Natural&);
+  Natural& operator-=(const Natural&);  // the argument must not be larger
+  Natural& operator*=(const limb_type);
+  Natural& operator*=(const Natural&);
+
+  bool is_zero() const;
+  const std::vector<limb_type>& limbs() const;
+
+  // return base raised to the power of exponent
+  static Natural pow(const Natural& base, unsigned long long exponent);
+
+  // return the product of two numbers (Karatsuba's algorithm is used for
+  // large numbers, and its three smaller products are worked out on
+  // separate threads, up to the given number of threads)
+  static Natural multiply(const Natural&, const Natural&,
+                          const unsigned threads = 1);
+
+  // divide the first argument by the second (which must not be zero)
+  static void divide(const Natural&, const Natural&,
+                     Natural& quotient, Natural& remainder);
+
+  // convert a list of digit values (most significant first) in the given
+  // base into a number, and back again (to_digits returns no digits for
+  // zero). Large numbers are split in two recursively, the halves being
+  // worked on by separate threads (up to the given number of threads) and
+  // joined using tables of powers of the base, so the conversions take
+  // less than quadratic time.
+  static Natural from_digits(const std::vector<std::size_t>&,
+                             const std::size_t base,
+                             const unsigned threads = 1);
+  std::vector<std::size_t> to_digits(const std::size_t base,
+                                     const unsigned threads = 1) const;
+
+protected:
+  void raw_trim();
+};
+
+
+
+/** struct Numeric_Value
+ *
+ * struct records the value of a number independently of its format, so the
+ * values of numbers of different formats can be hashed and compared. The
+ * value is held in the scientific form
+ *      [-] 0.{digits} x base^{exponent + scale}
+ * where the first and last of the digits are not zero, so that each value
+ * of a given base has just one set of digits and one power of base (the
+ * power may be split between exponent and scale in more than one way, as
+ * 10e0 and 1e1 split it). Values of different bases are equal
+ * if the numbers they describe are equal: so the values of 0x10, 020,
+ * 0b10000, 16, 16.0 and 1.6e1 are all equal (and hash the same) in their
+ * respective formats.
+ *
+ */
+struct Numeric_Value {
+  // ctor
+  Numeric_Value();
+  // overload == operator
+  bool operator==(const Numeric_Value&) const;
+  // overload != operator
+  bool operator!=(const Numeric_Value&) const;
+
+  // return a hash of the number that only depends on the number itself:
+  // the rational number it describes, modulo 2^61 - 1.
+  std::size_t hash() const;
+
+  // data members:
+  bool  is_number;
+    // is the value a number (all values that are not are equal)
+  bool  is_zero;
+    // is the number zero (digits is then empty)
+  bool  is_positive;
+    // is the number positive
+  std::size_t  base;
+    // the number of digits in the number's format
+  width_type  exponent;
+  width_type  scale;
+    // the power of base in the scientific form, as above, is exponent +
+    // scale: scale is the exponent written with the number, and exponent
+    // the place of the point among its digits (the sum need not fit in a
+    // width_type)
+  std::vector<std::size_t>  digits;
+    // the values of the digits in the scientific form, as above
+};
+
+
+
+/** struct Byte_Automaton
+ *
+ * struct records a deterministic automaton that reads a string a byte at a
+ * time and accepts the strings that a narrow format's compare accepts as
+ * numbers (see Basic_Format::automaton), laid out for a scanner: each byte
+ * is mapped to its class, and the next state is found by the state and the
+ * class,
+ *      state = transitions[state * class_count + classes[byte]]
+ * from state 0. A string is a number if the state after its last byte is
+ * accepting; the dead state is never left, so a scan may stop as soon as
+ * it is reached. If exact is false, the format limits how many times a
+ * digit may be used (see Basic_Digit), which the automaton does not count:
+ * it then accepts every number, but also some strings that are not.
+ *
+ * serialize writes the automaton as a block of bytes: the four bytes
+ * "ADFA", then the version, class_count, the number of states, dead and
+ * exact as 32-bit little-endian words, then classes (256 bytes), accepting
+ * (a byte for each state, padded with zeros to a multiple of four) and
+ * transitions (32-bit little-endian words). deserialize reads a block
+ * back, returning false if it is not one.
+ *
+ */
+struct Byte_Automaton {
+  static const std::uint32_t  version = 1;
+
+  // ctor: an automaton with no states, which accepts nothing
+  Byte_Automaton();
+
+  // does the automaton accept the string
+  bool matches(const char* first, const char* last) const;
+  bool matches(const std::string&) const;
+
+  std::string  serialize() const;
+  static bool  deserialize(const std::string&, Byte_Automaton&);
+
+  // data members:
+  std::uint32_t               class_count;
+    // the number of byte classes
+  std::uint32_t               dead;
+    // the dead state
+  bool                        exact;
+    // does the automaton accept the numbers and nothing else (as above)
+  std::vector<std::uint8_t>   classes;
+    // the class of each byte (256 of them)
+  std::vector<std::uint8_t>   accepting;
+    // is each state accepting (1) or not (0)
+  std::vector<std::uint32_t>  transitions;
+    // the next state, by state and class (as above)
+};
+
+
+
+/** struct Column
+ *
+ * struct holds a column of numbers decoded from text by
+ * Basic_Format::decode, laid out as columnar analytics code (e.g., Apache
+ * Arrow) expects: a contiguous buffer of native values, one per row, and a
+ * validity bitmap with one bit per row (least significant bit first), set
+ * for the rows that hold a number. TValue is one of std::int64_t,
+ * std::uint64_t and double.
+ *
+ */
+template <typename TValue>
+struct Column {
+  typedef TValue  value_type;
+
+  // ctor
+  Column();
+
+  std::size_t size() const;
+    // the number of rows
+  bool is_valid(const std::size_t row) const;
+    // does the row hold a number (is its validity bit set)
+
+  // data members:
+  std::vector<value_type>  values;
+    // the value of each row (zero for the rows that are null)
+  std::vector<std::uint8_t>  validity;
+    // the validity bitmap, (size()+7)/8 bytes long
+  std::size_t  null_count;
+    // the number of rows that are null
+  std::vector<std::size_t>  rejected;
+    // the rows that are null because they hold something that is not a
+    // number of the format, or a number that the value type cannot hold
+    // (empty rows are null but are not rejected)
+};
+
+
+
+/** struct Basic_Batch
+ *
+ * struct holds the numbers converted by Basic_Format::to_batch, packed so
+ * that they can be handed to I/O (or to columnar code, as Column is)
+ * without a string per row: the characters of every row in one contiguous
+ * buffer, the offset of each row's first character in it, and a validity
+ * bitmap with one bit per row (least significant bit first), set for the
+ * rows that were converted. Row i is the characters from offsets[i] up to
+ * offsets[i+1]; rows that are null are empty.
+ *
+ */
+template <typename TChar>
+struct Basic_Batch {
+  typedef TChar                         char_type;
+  typedef std::basic_string<char_type>  string;
+
+  // ctor
+  Basic_Batch();
+
+  std::size_t size() const;
+    // the number of rows
+  bool is_valid(const std::size_t row) const;
+    // was the row converted (is its validity bit set)
+  const char_type* data(const std::size_t row) const;
+  std::size_t length(const std::size_t row) const;
+    // the first character of the row in the buffer, and its length
+  string get(const std::size_t row) const;
+    // a copy of the row
+
+  // data members:
+  string  buffer;
+    // the characters of all the rows, one after the other
+  std::vector<std::size_t>  offsets;
+    // the offset of each row in the buffer, and then the buffer's length
+    // (so there are size()+1 of them)
+  std::vector<std::uint8_t>  validity;
+    // the validity bitmap, (size()+7)/8 bytes long
+  std::size_t  null_count;
+    // the number of rows that are null
+  std::vector<std::size_t>  rejected;
+    // the rows that are null because they hold something that is not an
+    // integer literal of the format (empty rows are null but are not
+    // rejected)
+};
+
+
+
+template <typename TChar, typename TCounter> class Basic_Predefined_Format;
+template <typename TChar, typename TCounter> class Basic_Push_Parser;
+
+
+
 /** class Basic_Format
  *
  * class records a number format; that is, information on what all numbers
@@ -353,6 +820,76 @@ public:
   typedef std::vector<digit_type>           digits_type;
   typedef std::basic_string<char_type>      string;
   typedef Arithmos::width_type              width_type;
+
+  /** struct Symbols
+   *
+   * the characters, other than the digits, that make up a number of the
+   * format:
+   *   point      - the decimal point (by default, `.')
+   *   plus       - the positive sign, of the number or of its exponent
+   *   minus      - the negative sign, as plus
+   *   separator  - a character that may separate groups of digits in the
+   *                whole part of the number (before the point), as the
+   *                commas in 1,234,567.89; a null character (the default)
+   *                allows no separator
+   *   group      - the number of digits in each group: every group but the
+   *                first (which may be shorter) must have this many. Zero
+   *                allows groups of any (non-zero) width.
+   *
+   * The separators are not part of a number's normalized string; the other
+   * symbols are.
+   *
+   */
+  struct Symbols {
+    constexpr Symbols(const char_type point = char_type('.'),
+                      const char_type plus = char_type('+'),
+                      const char_type minus = char_type('-'),
+                      const char_type separator = char_type(0),
+                      const std::size_t group = 0)
+      : point{point}, plus{plus}, minus{minus}, separator{separator},
+        group{group} {}
+
+    char_type    point;
+    char_type    plus;
+    char_type    minus;
+    char_type    separator;
+    std::size_t  group;
+  };
+
+  /** struct Limits
+   *
+   * the most that a parse or a conversion will take on, so that input from
+   * an untrusted source is rejected after a bounded amount of work (that
+   * is, in time proportional to the limit, not to the input). Zero (the
+   * default) is no limit:
+   *   length    - the length of the string. A string over it is rejected
+   *               before any of it is read.
+   *   digits    - the digits of the number before the exponent, less
+   *               the leading zeros of its whole part
+   *   exponent  - the magnitude of the exponent (its value, whatever its
+   *               sign)
+   *   cost      - the work that a conversion may do, counted as the
+   *               square of the number of digits converted, summed over
+   *               the whole part and the exponent (a conversion takes time
+   *               that grows with that square)
+   *
+   * Each limit has an error of its own (errc::length_limit, digit_limit,
+   * exponent_limit and cost_limit).
+   *
+   */
+  struct Limits {
+    constexpr Limits(const std::size_t length = 0,
+                     const std::size_t digits = 0,
+                     const unsigned long long exponent = 0,
+                     const unsigned long long cost = 0)
+      : length{length}, digits{digits}, exponent{exponent}, cost{cost} {}
+
+    std::size_t         length;
+    std::size_t         digits;
+    unsigned long long  exponent;
+    unsigned long long  cost;
+  };
+
 protected:
   typedef typename string::size_type        str_size_type;
 
@@ -367,6 +904,8 @@ private:
   digits_type  exp_digits_;
     // the digits allowed in the exponent. Usually as digits_ excluding the
     // period symbol
+  Symbols      symbols_;
+    // the decimal point, sign and digit-group separator characters
 
 protected:
   /** struct Split
@@ -423,23 +962,137 @@ protected:
     // ctors
     Count(const count_type);
 
+    // zero the counts of the given number of digits (reusing the capacity
+    // of the list)
+    void reset(const count_type);
+
     // data members
     std::vector<count_type> count_list_;
   };
 
 
+  /** struct Scientific
+   *
+   * After a Basic_Data object has been populated, this struct records the
+   * number it represents in the scientific form
+   *      [-] 0.{digits} x base^{exponent + scale}
+   * where base is the number of digits in the format, the first of the
+   * digits is not zero and the last is not zero either (so the form is
+   * unique). The digits are recorded as their positions in the format's
+   * digit list (their values), so 0x1a0p2 is recorded as {1, 10} with an
+   * exponent of 3 and a scale of 2. The scale is the exponent written
+   * with the number and is kept apart, as the sum need not fit in a
+   * width_type.
+   *
+   * struct data members:
+   *   zero      (bool)    - is the number zero (digits is then empty).
+   *   positive  (bool)    - is the number positive.
+   *   exponent  (width_type)
+   *                       - the place of the point among the digits, as
+   *                         above.
+   *   scale     (width_type)
+   *                       - the exponent of the number, as above.
+   *   digits    (vector)  - the digit values, as above.
+   */
+  struct Scientific {
+    // ctors
+    Scientific();
+
+    // data members
+    bool                        zero;
+    bool                        positive;
+    width_type                  exponent;
+    width_type                  scale;
+    std::vector<std::size_t>    digits;
+  };
+
+
+  /** struct Groups
+   *
+   * checks the placing of the digit-group separators in the whole part of
+   * a number as its characters are met: no separator may start or end the
+   * whole part or follow another, and the groups must have the format's
+   * width (see Symbols).
+   *
+   */
+  struct Groups {
+    // ctor
+    explicit Groups(const std::size_t width);
+
+    // count a digit of the whole part
+    void digit();
+    // meet a separator, returning false if it is misplaced
+    bool separator();
+    // end the whole part, returning false if the last group is incomplete
+    bool end() const;
+
+    // data members
+    std::size_t  width_;
+    std::size_t  count_;      // the digits in the current group
+    bool         separated_;  // has a separator been met
+  };
+
+
 public:
+  /** class Context
+   *
+   * the scratch state of a parse (the digit counts), of a conversion
+   * (the parsed number and its split parts) and of the arithmetic (the
+   * operands and result), kept between calls to compare_into, to_into and
+   * the *_into arithmetic so that their capacity is reused: once a
+   * context has been used on numbers as long as the next, compare_into and
+   * the *_into arithmetic allocate nothing more, nor does to_into while the
+   * number fits in a width_type. (A longer number is converted with
+   * Natural, whose working numbers are allocated afresh on each call.) A
+   * context may be used with any format of the class, but by one thread at
+   * a time.
+   *
+   */
+  class Context {
+  public:
+    // ctor
+    Context();
+
+  private:
+    friend class Basic_Format;
+
+    Count                  digit_count_;
+    Count                  exp_digit_count_;
+    Basic_Data<char_type>  data_;
+    Split                  split_;
+    // the second operand of the arithmetic, and the scientific forms of
+    // the operands and the result
+    Basic_Data<char_type>  other_;
+    Scientific             lhs_;
+    Scientific             rhs_;
+    Scientific             result_;
+  };
+
+
   // ctor
   Basic_Format(const string&        specifier,
                const digits_type&   digits,
                const string&        exp_string,
-               const digits_type&   exp_digits);
+               const digits_type&   exp_digits,
+               const Symbols&       symbols = Symbols());
+
+  // return errc::invalid_format if the constructor would throw with these
+  // arguments, or errc::ok otherwise (without allocating)
+  static errc validate(const digits_type& digits,
+                       const digits_type& exp_digits,
+                       const Symbols& symbols = Symbols()) noexcept;
+  static errc validate(const Basic_Predefined_Digits<char_type,count_type>&
+                                                                 digits,
+                       const Basic_Predefined_Digits<char_type,count_type>&
+                                                                 exp_digits,
+                       const Symbols& symbols = Symbols()) noexcept;
 
   // get methods (return specififc class data members)
   const string&       specifier() const;
   const digits_type&  digits() const;
   const string&       exponent_specifier() const;
   const digits_type&  exponent_digits() const;
+  const Symbols&      symbols() const;
 
   // the most important method of the class: this method returns data on the
   // input string as to that strings conformance and properties with respect
@@ -447,55 +1100,1286 @@ public:
   // recorded in the Basic_Data struct
   Basic_Data<char_type> compare(const string&) const;
 
-  string to(const Basic_Format&, const string&) const;
-  string to(const Basic_Format&, const Basic_Data<char_type>&) const;
+  // as compare, but also returning why the string is not a number, and
+  // where (see Status); neither throws
+  Status parse(const string&, Basic_Data<char_type>&) const noexcept;
+  // as parse, but rejecting strings over the limits (see Limits)
+  Status parse(const string&, Basic_Data<char_type>&,
+               const Limits&) const noexcept;
+
+  // as compare, but refilling the given Basic_Data rather than returning a
+  // new one: its strings are cleared, not replaced, so their capacity is
+  // reused. With a Context (see above) for the digit counts too, a loop
+  // over many strings allocates nothing once its buffers have grown.
+  void compare_into(const string&, Basic_Data<char_type>&) const;
+  void compare_into(const string&, Basic_Data<char_type>&, Context&) const;
+
+  // as to, but appending the converted number to the output string and
+  // returning why a string could not be converted (see Status)
+  template <typename TDestChar, typename TDestCounter>
+  Status convert(const Basic_Format<TDestChar,TDestCounter>&, const string&,
+                 std::basic_string<TDestChar>&,
+                 const unsigned threads = 1) const noexcept;
+  // as convert, but rejecting strings over the limits (see Limits)
+  template <typename TDestChar, typename TDestCounter>
+  Status convert(const Basic_Format<TDestChar,TDestCounter>&, const string&,
+                 std::basic_string<TDestChar>&, const Limits&,
+                 const unsigned threads = 1) const noexcept;
+
+  // convert a number to another format. The last argument is the most
+  // threads that one conversion may use: numbers too large for the
+  // native integer types are split in two recursively and the halves
+  // converted on separate threads (see Natural::from_digits). A part for
+  // which no thread can be started is converted on the calling thread.
+  string to(const Basic_Format&, const string&,
+            const unsigned threads = 1) const;
+  string to(const Basic_Format&, const Basic_Data<char_type>&,
+            const unsigned threads = 1) const;
+
+  // convert to a format of a different character type (so, a WFormat
+  // number can be converted straight into a narrow Format string without
+  // transcoding it first). The last overload appends the converted number
+  // to the given output string rather than returning a new one.
+  template <typename TDestChar, typename TDestCounter>
+  std::basic_string<TDestChar>
+  to(const Basic_Format<TDestChar,TDestCounter>&, const string&,
+     const unsigned threads = 1) const;
+  template <typename TDestChar, typename TDestCounter>
+  std::basic_string<TDestChar>
+  to(const Basic_Format<TDestChar,TDestCounter>&,
+     const Basic_Data<char_type>&, const unsigned threads = 1) const;
+  template <typename TDestChar, typename TDestCounter>
+  void
+  to(const Basic_Format<TDestChar,TDestCounter>&,
+     const Basic_Data<char_type>&, std::basic_string<TDestChar>&,
+     const unsigned threads = 1) const;
+
+  // as to, but replacing the contents of the given output string (which is
+  // left empty if the input cannot be converted) rather than returning a
+  // new one; with a Context, the number is parsed and split in its buffers
+  template <typename TDestChar, typename TDestCounter>
+  void
+  to_into(const Basic_Format<TDestChar,TDestCounter>&, const string&,
+          std::basic_string<TDestChar>&, const unsigned threads = 1) const;
+  template <typename TDestChar, typename TDestCounter>
+  void
+  to_into(const Basic_Format<TDestChar,TDestCounter>&, const string&,
+          std::basic_string<TDestChar>&, Context&,
+          const unsigned threads = 1) const;
+  template <typename TDestChar, typename TDestCounter>
+  void
+  to_into(const Basic_Predefined_Format<TDestChar,TDestCounter>&,
+          const string&, std::basic_string<TDestChar>&,
+          const unsigned threads = 1) const;
+  template <typename TDestChar, typename TDestCounter>
+  void
+  to_into(const Basic_Predefined_Format<TDestChar,TDestCounter>&,
+          const string&, std::basic_string<TDestChar>&, Context&,
+          const unsigned threads = 1) const;
+
+  // convert to one of the library's pre-defined formats (e.g.,
+  // Arithmos::decimal), whatever its character type
+  template <typename TDestChar, typename TDestCounter>
+  std::basic_string<TDestChar>
+  to(const Basic_Predefined_Format<TDestChar,TDestCounter>&,
+     const string&, const unsigned threads = 1) const;
+  template <typename TDestChar, typename TDestCounter>
+  std::basic_string<TDestChar>
+  to(const Basic_Predefined_Format<TDestChar,TDestCounter>&,
+     const Basic_Data<char_type>&, const unsigned threads = 1) const;
+
+  // convert a number that need not be an integer to another format: its
+  // fraction is written with at most the given number of places (digits
+  // after the point), exactly if it ends within them and otherwise rounded
+  // to them. The digits of the fraction are worked out one at a time, so
+  // the places bound the work. The exponent of an integer literal is
+  // converted digit for digit, as with to; that of any other number is
+  // folded into its digits first (so 0xffp-12 is written without one).
+  // The result is empty if the input is not a number, or if its whole part
+  // would be too long to hold in a string.
+  template <typename TDestChar, typename TDestCounter>
+  std::basic_string<TDestChar>
+  to_places(const Basic_Format<TDestChar,TDestCounter>&, const string&,
+            const std::size_t places,
+            const Rounding = Rounding::nearest_even,
+            const unsigned threads = 1) const;
+  template <typename TDestChar, typename TDestCounter>
+  std::basic_string<TDestChar>
+  to_places(const Basic_Format<TDestChar,TDestCounter>&,
+            const Basic_Data<char_type>&, const std::size_t places,
+            const Rounding = Rounding::nearest_even,
+            const unsigned threads = 1) const;
+  template <typename TDestChar, typename TDestCounter>
+  std::basic_string<TDestChar>
+  to_places(const Basic_Predefined_Format<TDestChar,TDestCounter>&,
+            const string&, const std::size_t places,
+            const Rounding = Rounding::nearest_even,
+            const unsigned threads = 1) const;
+  template <typename TDestChar, typename TDestCounter>
+  std::basic_string<TDestChar>
+  to_places(const Basic_Predefined_Format<TDestChar,TDestCounter>&,
+            const Basic_Data<char_type>&, const std::size_t places,
+            const Rounding = Rounding::nearest_even,
+            const unsigned threads = 1) const;
+
+  // convert many numbers to another format at once, packing the results
+  // into one buffer (see struct Basic_Batch). The digit tables and the
+  // scratch state of a conversion are set up once and reused for every
+  // row, and the rows are written straight into the buffer. Rows that to
+  // would return empty are null.
+  template <typename TDestChar, typename TDestCounter>
+  Basic_Batch<TDestChar>
+  to_batch(const Basic_Format<TDestChar,TDestCounter>&,
+           const std::vector<string>&, const unsigned threads = 1) const;
+  template <typename TDestChar, typename TDestCounter>
+  Basic_Batch<TDestChar>
+  to_batch(const Basic_Predefined_Format<TDestChar,TDestCounter>&,
+           const std::vector<string>&, const unsigned threads = 1) const;
+
+  // compare two numbers of this format by their numerical value, without
+  // converting them to any other type. Returns a negative number if the
+  // first is the smaller, zero if they are equal and a positive number if
+  // the first is the larger. Strings that are not numbers are ordered
+  // before all numbers (and are equal to each other).
+  int order(const string&, const string&) const;
+  int order(const Basic_Data<char_type>&, const Basic_Data<char_type>&) const;
+
+  // return a binary key for a number such that the keys of any two numbers
+  // of this format compare (with memcmp, or as std::strings) in the same
+  // order as the numbers themselves (see `order'). The key of a string
+  // that is not a number is empty.
+  std::string sort_key(const string&) const;
+  std::string sort_key(const Basic_Data<char_type>&) const;
+
+  // return the value of a number independently of this format (see struct
+  // Numeric_Value), and its hash: numbers of any format that are equal
+  // have equal values and hashes.
+  Numeric_Value value(const string&) const;
+  Numeric_Value value(const Basic_Data<char_type>&) const;
+  std::size_t hash(const string&) const;
+  std::size_t hash(const Basic_Data<char_type>&) const;
+
+  // decode a column of numbers, separated by the delimiter, into native
+  // values in a single pass over the text (see struct Column), without
+  // building a string or a Basic_Data for each row. With the default
+  // delimiter, a carriage return before each newline is ignored; a
+  // delimiter at the very end of the text does not start another row.
+  // Numbers that are not integers are rejected from integer columns, as
+  // are numbers that are too large for them.
+  template <typename TValue>
+  Column<TValue> decode(const string&,
+                        const char_type delimiter = char_type('\n')) const;
+  template <typename TValue>
+  Column<TValue> decode(const char_type* first, const char_type* last,
+                        const char_type delimiter = char_type('\n')) const;
+
+  // round a number to the given number of significant digits (at least
+  // one), or to the given number of fractional places (digits after the
+  // point; a negative number of places rounds to a multiple of a power of
+  // the base), or truncate it to an integer. The result is normalized (as
+  // by compare) and keeps the number's exponent; it is empty if the input
+  // is not a number, if it rounds to a unit whose place does not fit in a
+  // width_type (or whose zeros, written with that exponent, would not fit
+  // in a string), or if the result uses a digit more times than the format
+  // allows. The arithmetic is done on the digits themselves, in the
+  // format's own base.
+  string round(const string&, const std::size_t digits,
+               const Rounding = Rounding::nearest_even) const;
+  string round(const Basic_Data<char_type>&, const std::size_t digits,
+               const Rounding = Rounding::nearest_even) const;
+  string round_places(const string&, const width_type places,
+                      const Rounding = Rounding::nearest_even) const;
+  string round_places(const Basic_Data<char_type>&, const width_type places,
+                      const Rounding = Rounding::nearest_even) const;
+  string truncate(const string&) const;
+  string truncate(const Basic_Data<char_type>&) const;
+
+  // a regular expression, in the syntax given, that matches the whole of
+  // the strings that compare accepts as numbers and nothing else, and an
+  // automaton over bytes (for a format whose characters are all below 256)
+  // that accepts the same strings. Neither counts the uses of the digits:
+  // a format with a digit that may be used only so many times (see
+  // Basic_Digit) gets a pattern and an automaton that accept some strings
+  // that are not numbers too (those using the digit too often). Nor can
+  // the pattern say that the exponent string is where it is first found,
+  // so it also accepts more if the exponent string is longer than a
+  // character and starts with a character of the whole part or, if there
+  // is no specifier, a sign. pattern_exact returns whether the pattern
+  // accepts the numbers and nothing else; the automaton says so in its
+  // exact member. A format with characters of 256 or over gets an
+  // automaton with no states (which accepts nothing).
+  string         pattern(const Syntax = Syntax::ecmascript) const;
+  bool           pattern_exact() const;
+  Byte_Automaton automaton() const;
+
+  // arithmetic on numbers of this format, done on their digits in its own
+  // base, so the numbers can be of any length and nothing is lost. The
+  // result is normalized (as by compare), with the smaller of the
+  // operands' exponents for a sum or difference, and their sum for a
+  // product; it is empty if an operand is not a number, if the result
+  // needs an exponent that does not fit in a width_type (or the one that
+  // cannot be negated, its minimum), or if it uses a digit more times than
+  // the format allows. sign returns -1, 0 or 1 as the
+  // number is negative, zero (or not a number) or positive.
+  string add(const string&, const string&) const;
+  string add(const Basic_Data<char_type>&,
+             const Basic_Data<char_type>&) const;
+  string subtract(const string&, const string&) const;
+  string subtract(const Basic_Data<char_type>&,
+                  const Basic_Data<char_type>&) const;
+  string multiply(const string&, const string&) const;
+  string multiply(const Basic_Data<char_type>&,
+                  const Basic_Data<char_type>&) const;
+  string negate(const string&) const;
+  string negate(const Basic_Data<char_type>&) const;
+  int    sign(const string&) const;
+  int    sign(const Basic_Data<char_type>&) const;
+
+  // as above, but replacing the contents of the given output string (which
+  // may be one of the operands), with the operands and the result kept in
+  // the context's buffers: a running total kept with add_into allocates
+  // nothing once the buffers have grown to its length
+  void add_into(const string&, const string&, string&, Context&) const;
+  void subtract_into(const string&, const string&, string&, Context&) const;
+  void multiply_into(const string&, const string&, string&, Context&) const;
+  void negate_into(const string&, string&, Context&) const;
 
 protected:
+  /** struct Lookup
+   *
+   * struct records the position of each character in a digit list (the
+   * main list, with its decimal point, or the exponent list) so that it is
+   * looked up in a table, rather than searched for, for the characters
+   * below 256; the struct also counts the digits of a number against their
+   * maximum counts.
+   *
+   */
+  struct Lookup {
+    static const std::size_t npos = static_cast<std::size_t>(-1);
+
+    // ctor
+    Lookup(const digits_type&);
+
+    // the position of the character in the list, or npos
+    std::size_t find(const char_type) const;
+    // count a digit (by its position), returning false if it has been
+    // seen too many times
+    bool count(const std::size_t);
+    // start counting afresh
+    void reset();
+
+    // data members
+    const digits_type&        digits_;
+    std::size_t               table_[256];
+    std::vector<count_type>   count_list_;
+    bool                      limited_;
+  };
+
+  // decode a single row into the value, returning false if the row is not
+  // a number (or the value type cannot hold it)
+  template <typename TValue>
+  bool raw_decode(const char_type*, const char_type*, Lookup&, Lookup&,
+                  TValue&) const;
+  // the value m x base^scale (negated if the bool is true), or false if
+  // the value type cannot hold it
+  bool raw_value(unsigned long long, width_type, const bool,
+                 std::uint64_t&) const;
+  bool raw_value(unsigned long long, width_type, const bool,
+                 std::int64_t&) const;
+  bool raw_value(unsigned long long, width_type, const bool,
+                 double&) const;
+
   // conversion functions:
   width_type raw_str_to_int(const string&, const bool = true) const;
+  width_type raw_str_to_int(const string&, const Lookup&,
+                            const bool = true) const;
+
+  // return the value of a digit (its position in the digit list, or in the
+  // exponent digit list if the second argument is false), or the size of
+  // the digit list if it is not a digit
+  std::size_t raw_digit_value(const char_type, const bool = true) const;
 
-  string     raw_int_to_str(const Basic_Format&, width_type,
+  template <typename TDestChar, typename TDestCounter>
+  void       raw_int_to_str(const Basic_Format<TDestChar,TDestCounter>&,
+                            width_type, std::basic_string<TDestChar>&,
                             const bool = true) const;
 
-  string     raw_convert(const Basic_Format& dest, const string& input,
-                         const bool = true) const;
+  // convert the digits (of the main list, or of the exponent list if the
+  // bool is false) into the destination's, looking them up in the table
+  // if one is given
+  template <typename TDestChar, typename TDestCounter>
+  void       raw_convert(const Basic_Format<TDestChar,TDestCounter>& dest,
+                         const string& input,
+                         std::basic_string<TDestChar>& output,
+                         const bool = true,
+                         const unsigned threads = 1,
+                         const Lookup* = nullptr) const;
+
+  // write the split number in the destination format
+  template <typename TDestChar, typename TDestCounter>
+  void       raw_to(const Basic_Format<TDestChar,TDestCounter>& dest,
+                    const Split&, std::basic_string<TDestChar>& output,
+                    const unsigned threads = 1,
+                    const Lookup* whole = nullptr,
+                    const Lookup* exponent = nullptr) const;
 
   Split      raw_split(const Basic_Data<char_type>&) const;
+  void       raw_split(const Basic_Data<char_type>&, Split&) const;
+
+  Status     raw_parse(const string&, Basic_Data<char_type>&, Context&,
+                       const Limits& = Limits()) const noexcept;
+
+  template <typename TDigits>
+  static errc raw_validate(const TDigits& digits, const TDigits& exp_digits,
+                           const Symbols& symbols) noexcept;
+
+  // is the string [sign][specifier][last], a null sign or last character
+  // being absent (compared in place, so nothing is allocated)
+  bool       raw_is(const string&, const char_type sign,
+                    const char_type last) const noexcept;
+
+  Status     raw_fail(Basic_Data<char_type>&, const errc,
+                      const str_size_type) const noexcept;
+
+  void       raw_scientific(const Basic_Data<char_type>&, Scientific&) const;
+
+  int        raw_order(const Scientific&, const Scientific&) const;
+
+  // move the point of a split number that is not an integer literal by its
+  // exponent, so that it has none, for a conversion to the given base with
+  // the given places (false if the whole part would not fit in a string)
+  bool       raw_fold(Split&, const width_type exponent,
+                      const std::size_t dest_base,
+                      const std::size_t places) const;
+
+  // write the split number, fraction and all, in the destination format,
+  // with at most the given number of places after the point
+  template <typename TDestChar, typename TDestCounter>
+  void       raw_to_places(const Basic_Format<TDestChar,TDestCounter>& dest,
+                           const Split&, std::basic_string<TDestChar>& output,
+                           const std::size_t places, const Rounding,
+                           const unsigned threads = 1) const;
+
+  // compare the digit values from the given one on, read as a fraction in
+  // this format's base (with no trailing zeros), to one half: -1, 0 or 1
+  int        raw_against_half(const std::vector<std::size_t>&,
+                              std::size_t) const;
+  // whether a number with the sign, and with the last kept digit odd or
+  // not, rounds away from zero, given how its dropped digits compare to
+  // half a unit in the last place kept
+  static bool raw_round_up(const Rounding, const int against_half,
+                           const bool positive, const bool last_odd);
+  // (false if the number rounds up to a unit whose place does not fit in a
+  // width_type)
+  bool       raw_round(Scientific&, const width_type, const Rounding) const;
+  string     raw_format(const Scientific&) const;
+  void       raw_format(const Scientific&, string&) const;
+
+  // the sum (or difference, if the bool is true) and the product of two
+  // numbers in scientific form, into a third (which must be neither); the
+  // sum is false if its exponent would not fit in a width_type
+  bool       raw_add(const Scientific&, const Scientific&, const bool,
+                     Scientific&) const;
+  void       raw_multiply(const Scientific&, const Scientific&,
+                          Scientific&) const;
+  // the sum or difference of two widths, false if it would not fit in one
+  static bool raw_checked_add(const width_type, const width_type,
+                              width_type&) noexcept;
+  static bool raw_checked_subtract(const width_type, const width_type,
+                                   width_type&) noexcept;
+  // drop the leading and trailing zeros of a result (see Scientific)
+  static void raw_trim(Scientific&);
+  // compare the magnitudes of two non-zero numbers: -1, 0 or 1
+  static int raw_order_magnitude(const Scientific&, const Scientific&);
+  // compare the powers of base of two non-zero numbers (exponent + scale):
+  // -1, 0 or 1
+  static int raw_order_exponent(const Scientific&, const Scientific&)
+                                                                 noexcept;
+
+  // does a digit (other than the point) or an exponent digit have a limit
+  // on its uses
+  bool       raw_counted() const;
+  // the characters that may be read as the part of a number before its
+  // exponent: the digits, the point and the separator, bar the exponent
+  // string if it is one of those characters
+  std::vector<char_type> raw_whole_characters() const;
+
+  // the parsed operands' arithmetic (see add_into), written to the output
+  enum class Operation { add, subtract, multiply, negate };
+  void       raw_arithmetic(const Operation, const Basic_Data<char_type>&,
+                            const Basic_Data<char_type>&, string&,
+                            Context&) const;
+
+  friend class Basic_Push_Parser<TChar,TCounter>;
+};
+
+
+/** class Basic_Predefined_Format
+ *
+ * class records a number format whose specifiers and digits are held in
+ * static arrays. Its constructor is constexpr, so objects of this class
+ * (like the library's Arithmos::decimal) are constant-initialized: no code
+ * is run to create them at program start-up, and they may be used safely
+ * from the constructors of other global objects. The Basic_Format that
+ * they describe is only built the first time that it is needed (in a
+ * thread-safe way), after which every call is forwarded to it:
+ *
+ *   Arithmos::Data d = Arithmos::decimal.compare("-12.5e3");
+ *
+ * The object converts to a `const Basic_Format&', so it can be passed to
+ * anything expecting a Basic_Format. The Basic_Format is never destroyed,
+ * so the object may also be used during static destruction.
+ *
+ */
+template <typename TChar, typename TCounter = count_type>
+class Basic_Predefined_Format {
+public:
+  typedef Basic_Format<TChar,TCounter>               format_type;
+  typedef typename format_type::char_type            char_type;
+  typedef typename format_type::count_type           count_type;
+  typedef typename format_type::digit_type           digit_type;
+  typedef typename format_type::digits_type          digits_type;
+  typedef typename format_type::string               string;
+  typedef typename format_type::width_type           width_type;
+  typedef Basic_Predefined_Digits<TChar,TCounter>    digits_view;
+
+private:
+  const char_type*  specifier_;
+  std::size_t       specifier_length_;
+  digits_view       digits_;
+  const char_type*  exp_;
+  std::size_t       exp_length_;
+  digits_view       exp_digits_;
+
+  // the lazily built Basic_Format: format_ points into storage_ once it has
+  // been built.
+  mutable std::atomic<const format_type*>  format_;
+  mutable std::mutex                        mutex_;
+  mutable typename std::aligned_storage<sizeof(format_type),
+                                        alignof(format_type)>::type storage_;
+
+public:
+  // ctor: arguments as for Basic_Format, but as static arrays
+  template <std::size_t N, std::size_t M,
+            std::size_t DN, std::size_t EN>
+  constexpr Basic_Predefined_Format(const char_type (&specifier)[N],
+                                    const digit_type (&digits)[DN],
+                                    const char_type (&exp_string)[M],
+                                    const digit_type (&exp_digits)[EN]);
+
+  Basic_Predefined_Format(const Basic_Predefined_Format&) = delete;
+  Basic_Predefined_Format& operator=(const Basic_Predefined_Format&) = delete;
+
+  // get the Basic_Format the object describes (building it if need be;
+  // once it is built, get allocates nothing)
+  const format_type& get() const;
+  operator const format_type&() const;
+
+  // the Basic_Format methods, forwarded to get()
+  const string&       specifier() const;
+  const digits_type&  digits() const;
+  const string&       exponent_specifier() const;
+  const digits_type&  exponent_digits() const;
+
+  template <typename... Args>
+  auto compare(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .compare(std::forward<Args>(args)...));
+  template <typename... Args>
+  auto to(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .to(std::forward<Args>(args)...));
+  template <typename... Args>
+  auto order(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .order(std::forward<Args>(args)...));
+  template <typename... Args>
+  auto sort_key(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .sort_key(std::forward<Args>(args)...));
+  template <typename... Args>
+  auto value(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .value(std::forward<Args>(args)...));
+  template <typename... Args>
+  auto hash(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .hash(std::forward<Args>(args)...));
+  template <typename... Args>
+  auto round(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .round(std::forward<Args>(args)...));
+  template <typename... Args>
+  auto round_places(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .round_places(std::forward<Args>(args)...));
+  template <typename... Args>
+  auto truncate(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .truncate(std::forward<Args>(args)...));
+  template <typename... Args>
+  auto parse(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .parse(std::forward<Args>(args)...));
+  template <typename... Args>
+  auto convert(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .convert(std::forward<Args>(args)...));
+  template <typename... Args>
+  auto to_batch(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .to_batch(std::forward<Args>(args)...));
+  template <typename... Args>
+  auto compare_into(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .compare_into(std::forward<Args>(args)...));
+  template <typename... Args>
+  auto to_into(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .to_into(std::forward<Args>(args)...));
+  template <typename... Args>
+  auto to_places(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .to_places(std::forward<Args>(args)...));
+  template <typename... Args>
+  auto pattern(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .pattern(std::forward<Args>(args)...));
+  template <typename... Args>
+  auto pattern_exact(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .pattern_exact(std::forward<Args>(args)...));
+  template <typename... Args>
+  auto automaton(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .automaton(std::forward<Args>(args)...));
+  template <typename... Args>
+  auto add(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .add(std::forward<Args>(args)...));
+  template <typename... Args>
+  auto subtract(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .subtract(std::forward<Args>(args)...));
+  template <typename... Args>
+  auto multiply(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .multiply(std::forward<Args>(args)...));
+  template <typename... Args>
+  auto negate(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .negate(std::forward<Args>(args)...));
+  template <typename... Args>
+  auto sign(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .sign(std::forward<Args>(args)...));
+  template <typename... Args>
+  auto add_into(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .add_into(std::forward<Args>(args)...));
+  template <typename... Args>
+  auto subtract_into(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .subtract_into(std::forward<Args>(args)...));
+  template <typename... Args>
+  auto multiply_into(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .multiply_into(std::forward<Args>(args)...));
+  template <typename... Args>
+  auto negate_into(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .negate_into(std::forward<Args>(args)...));
+};
+
+
+
+/** class Basic_Predefined_Translation
+ *
+ * class records a translation (see the translate function) as a pair of
+ * static strings of equal length: the character at position i of the
+ * first string is translated into the character at position i of the
+ * second. Like Basic_Predefined_Format, objects of this class are
+ * constant-initialized. The translate function accepts them directly, so
+ * no std::unordered_set need ever be built; one is made the first time the
+ * object is converted to a std::unordered_set<Basic_Congruence>, however.
+ *
+ */
+template <typename TChar>
+class Basic_Predefined_Translation {
+public:
+  typedef TChar                                      char_type;
+  typedef Basic_Congruence<char_type>                congruence_type;
+  typedef std::unordered_set<congruence_type>        translation_type;
+  typedef std::size_t                                size_type;
+
+private:
+  const char_type*  from_;    // the characters to translate...
+  const char_type*  to_;      // ...and what they translate into
+  size_type         size_;
+
+  mutable std::atomic<const translation_type*>  translation_;
+  mutable std::mutex                             mutex_;
+  mutable typename std::aligned_storage<sizeof(translation_type),
+                                        alignof(translation_type)>::type
+                                                 storage_;
+
+public:
+  // ctor
+  template <size_type N>
+  constexpr Basic_Predefined_Translation(const char_type (&from)[N],
+                                         const char_type (&to)[N]);
+
+  Basic_Predefined_Translation(const Basic_Predefined_Translation&)
+    = delete;
+  Basic_Predefined_Translation&
+    operator=(const Basic_Predefined_Translation&) = delete;
+
+  // return the character that the argument translates to (or the argument
+  // itself if it is not translated)
+  char_type normalize(const char_type) const;
+
+  // get the translation as a set of congruences (building it if need be)
+  const translation_type& get() const;
+  operator const translation_type&() const;
+};
+
+
+
+/** translate
+ *
+ * an overload of translate for the pre-defined translations.
+ *
+ */
+template <typename T>
+std::basic_string<T>
+translate(const std::basic_string<T>& input,
+          const Basic_Predefined_Translation<T>& translation);
+
+
+
+/** class Basic_Numeric_Less
+ *
+ * a comparison function object that orders the strings of a number format
+ * by their numerical value (see Basic_Format::order), so that, e.g.,
+ *
+ *   std::sort(v.begin(), v.end(), Numeric_Less(Arithmos::hexadecimal));
+ *
+ * sorts a vector of hexadecimal strings numerically. Every comparison
+ * parses both strings: to sort many strings it is quicker to sort them by
+ * their Basic_Format::sort_key.
+ *
+ */
+template <typename TChar, typename TCounter = count_type>
+class Basic_Numeric_Less {
+public:
+  typedef Basic_Format<TChar,TCounter>       format_type;
+  typedef typename format_type::string       string;
+
+private:
+  const format_type&  format_;
+
+public:
+  // ctor
+  explicit Basic_Numeric_Less(const format_type&);
+
+  bool operator()(const string&, const string&) const;
+};
+
+
+
+/** class Intern_Table
+ *
+ * class interns numbers by their value: each distinct value is given an
+ * id (0, 1, 2, ... in the order the values were first seen), and numbers
+ * of any format that are equal are given the same id. So, a table that
+ * interns 0x10, 020 and 16 (in the hexadecimal, octal and decimal formats)
+ * holds just one value, with id 0.
+ *
+ * The table is not synchronized: threads sharing one must lock it.
+ *
+ */
+class Intern_Table {
+public:
+  typedef std::size_t  id_type;
+
+  // the id returned for strings that are not numbers, and by find for
+  // values that are not in the table.
+  static const id_type npos = static_cast<id_type>(-1);
+
+private:
+  struct Hash {
+    std::size_t operator()(const Numeric_Value&) const;
+  };
+
+  std::unordered_map<Numeric_Value, id_type, Hash>  ids_;
+  std::vector<const Numeric_Value*>                 values_;
+
+public:
+  // return the id of the value, adding it to the table if it is new
+  id_type intern(const Numeric_Value&);
+  template <typename TFormat>
+  id_type intern(const TFormat& format, const typename TFormat::string&);
+
+  // return the id of the value if it is in the table, or npos otherwise
+  id_type find(const Numeric_Value&) const;
+  template <typename TFormat>
+  id_type find(const TFormat& format,
+               const typename TFormat::string&) const;
+
+  // return the value with the given id (which must be less than size)
+  const Numeric_Value& operator[](const id_type) const;
+
+  std::size_t size() const;
+  void clear();
+};
+
+
+
+/** class Basic_Cached_Format
+ *
+ * class wraps a Basic_Format and memoizes the results of its `compare'
+ * and `to' methods, keyed on the input string (and, for `to', on the
+ * address of the destination format, which must therefore outlive the
+ * cache). Workloads that see the same few numbers over and over can then
+ * skip the parsing and conversion altogether.
+ *
+ * The cache is bounded: each of its shards holds at most capacity/shards
+ * results of each kind (compare or to) and evicts them in CLOCK order
+ * (an approximation of least-recently-used that needs no list shuffling
+ * on a hit). An input is always looked up in the same shard, and each
+ * shard has its own lock, so threads sharing the cache only contend when
+ * their inputs fall in the same shard.
+ *
+ * The cache is opt-in: a plain Basic_Format carries none of this.
+ *
+ */
+template <typename TChar, typename TCounter = count_type>
+class Basic_Cached_Format {
+public:
+  typedef Basic_Format<TChar,TCounter>       format_type;
+  typedef typename format_type::char_type    char_type;
+  typedef typename format_type::string       string;
+  typedef Basic_Data<char_type>              data_type;
+  typedef std::size_t                        size_type;
+
+  /** struct Statistics
+   *
+   * the cache's counters, summed over all the shards:
+   *   hits       - lookups answered from the cache
+   *   misses     - lookups that had to call the wrapped format
+   *   evictions  - results dropped to make room for new ones
+   */
+  struct Statistics {
+    unsigned long long  hits;
+    unsigned long long  misses;
+    unsigned long long  evictions;
+  };
+
+private:
+  struct Key;
+  struct Key_Hash;
+  template <typename V> struct Clock;
+  struct Shard;
+
+  const format_type&        format_;
+  size_type                 shard_capacity_;
+  size_type                 shard_count_;
+  mutable std::vector<Shard> shards_;
+
+public:
+  // ctor: capacity is the total number of results to keep (rounded up to
+  // a multiple of shards)
+  Basic_Cached_Format(const format_type&,
+                      const size_type capacity = 4096,
+                      const size_type shards = 16);
+  ~Basic_Cached_Format();
+
+  Basic_Cached_Format(const Basic_Cached_Format&) = delete;
+  Basic_Cached_Format& operator=(const Basic_Cached_Format&) = delete;
+
+  // the wrapped format
+  const format_type& format() const;
+
+  // as the Basic_Format methods, but memoized
+  data_type compare(const string&) const;
+  string    to(const format_type&, const string&) const;
+
+  // the cache's counters
+  Statistics statistics() const;
+
+  // drop all the results (the counters are kept)
+  void clear();
+
+protected:
+  Shard& raw_shard(const string&) const;
+};
+
+
+
+/** class Basic_Format_Registry
+ *
+ * class holds named formats and translations for lookup by name, as when
+ * they are loaded from a configuration file. The registry's contents are
+ * held in an immutable `generation'; a writer replaces them all at once by
+ * publishing a new generation, and readers never see a mixture of the two.
+ *
+ * Lookups never block: a reader takes a Reader from `read', which pins the
+ * current generation until the Reader is destroyed, and looks names up in
+ * it. Taking a Reader costs an atomic increment and decrement of a counter
+ * in one of the registry's shards (chosen by thread, so that threads don't
+ * share a cache line); there is no lock. A writer that publishes a new
+ * generation waits for the Readers of the old one to go before freeing it
+ * (as RCU does), so the formats a reader has looked up stay valid for as
+ * long as it holds its Reader, however many times the registry is reloaded
+ * in the meantime.
+ *
+ * Writers are serialized by a mutex. A thread must not publish while it
+ * holds a Reader (it would wait for itself), and Readers must not outlive
+ * the registry.
+ *
+ */
+template <typename TChar, typename TCounter = count_type>
+class Basic_Format_Registry {
+public:
+  typedef Basic_Format<TChar,TCounter>                   format_type;
+  typedef typename format_type::char_type                char_type;
+  typedef typename format_type::string                   string;
+  typedef std::unordered_set<Basic_Congruence<TChar>>    translation_type;
+  typedef std::unordered_map<string, format_type>        format_map;
+  typedef std::unordered_map<string, translation_type>   translation_map;
+  typedef unsigned long long                             generation_type;
+
+  /** class Generation
+   *
+   * the immutable contents of the registry between two publishes.
+   *
+   */
+  class Generation {
+    friend class Basic_Format_Registry;
+
+    format_map       formats_;
+    translation_map  translations_;
+    generation_type  number_;
+
+  public:
+    // return the format or translation with the given name, or nullptr if
+    // there isn't one
+    const format_type*      format(const string&) const;
+    const translation_type* translation(const string&) const;
+
+    // the generation's number: 0 for the empty registry, then 1, 2, ...
+    // for each publish
+    generation_type number() const;
+  };
+
+  /** class Reader
+   *
+   * a read-side critical section: the generation that was current when
+   * the Reader was taken stays alive until the Reader is destroyed.
+   *
+   */
+  class Reader {
+    friend class Basic_Format_Registry;
+
+    const Basic_Format_Registry*  registry_;
+    std::size_t                   shard_;
+    std::size_t                   parity_;
+    const Generation*             generation_;
+
+    explicit Reader(const Basic_Format_Registry&);
+
+  public:
+    Reader(Reader&&);
+    ~Reader();
+
+    Reader(const Reader&) = delete;
+    Reader& operator=(const Reader&) = delete;
+    Reader& operator=(Reader&&) = delete;
+
+    const Generation& operator*() const;
+    const Generation* operator->() const;
+  };
+
+private:
+  struct Shard;
+
+  std::size_t                     shard_count_;
+  std::unique_ptr<char[]>         shard_block_;  // the shards' memory
+  Shard*                          shards_;       // (within shard_block_)
+  std::atomic<const Generation*>  current_;
+  std::atomic<std::size_t>        epoch_;
+  std::mutex                      write_mutex_;
+
+public:
+  // ctor: the registry starts empty (generation 0)
+  explicit Basic_Format_Registry(const std::size_t shards = 16);
+  ~Basic_Format_Registry();
+
+  Basic_Format_Registry(const Basic_Format_Registry&) = delete;
+  Basic_Format_Registry& operator=(const Basic_Format_Registry&) = delete;
+
+  // pin the current generation
+  Reader read() const;
+
+  // replace the registry's contents, wait for the readers of the old
+  // contents to finish with them, and return the new generation's number
+  generation_type publish(format_map, translation_map = translation_map());
+
+protected:
+  std::size_t raw_shard() const;
+  void raw_synchronize();
+  void raw_wait(const std::size_t parity) const;
+};
+
+
+
+/** class Basic_Catalog
+ *
+ * class is a read-only view of a catalog of named formats and translations
+ * that has been compiled (by `compile') into a single block of memory, as
+ * when a catalog file is mapped in by a Catalog_File. Opening a catalog
+ * checks the block, but neither parses nor copies it: the names are
+ * searched for in place (they are sorted), the digits and characters are
+ * read from the block, and the Basic_Format of an entry is only built the
+ * first time that it is used (as a Basic_Predefined_Format's is), so a
+ * program that loads a catalog of thousands of formats pays only for the
+ * ones it uses. The block must outlive the catalog.
+ *
+ * A block is laid out as:
+ *   header              - the magic string "ARITHMOS", the version, the
+ *                         byte order, the sizes of the character, counter
+ *                         and digit types, the numbers of formats and
+ *                         translations, the size of the block and a
+ *                         checksum (FNV-1a, by 64-bit words) of everything
+ *                         after the header
+ *   format entries      - the offsets and lengths of a format's name,
+ *                         specifier, digits (without the point), exponent
+ *                         string and exponent digits, and its symbols;
+ *                         sorted by name
+ *   translation entries - the offsets and lengths of a translation's name
+ *                         and of the characters that it translates from
+ *                         and to (the first sorted); sorted by name
+ *   data                - the names, strings, characters and digits (the
+ *                         Basic_Digit objects themselves), each aligned to
+ *                         eight bytes
+ * with every number in the machine's own byte order. A block written on a
+ * machine with a different byte order or type sizes, of another version,
+ * truncated or corrupted is rejected by validate (and the ctor), as is one
+ * whose entries are out of bounds or unsorted or whose formats could not be
+ * constructed.
+ *
+ */
+template <typename TChar, typename TCounter = count_type>
+class Basic_Catalog {
+public:
+  typedef Basic_Format<TChar,TCounter>                   format_type;
+  typedef typename format_type::char_type                char_type;
+  typedef typename format_type::count_type               count_type;
+  typedef typename format_type::digit_type               digit_type;
+  typedef typename format_type::string                   string;
+  typedef Basic_Predefined_Digits<TChar,TCounter>        digits_view;
+  typedef std::unordered_set<Basic_Congruence<TChar>>    translation_type;
+  typedef std::unordered_map<string, format_type>        format_map;
+  typedef std::unordered_map<string, translation_type>   translation_map;
+  typedef std::size_t                                    size_type;
+
+  // the version of the layout that compile writes and validate accepts
+  static const std::uint32_t version = 1;
+
+  // the index returned by find_format and find_translation for names that
+  // are not in the catalog
+  static const size_type npos = static_cast<size_type>(-1);
+
+private:
+  struct Header;
+  struct Format_Entry;
+  struct Translation_Entry;
+
+  const unsigned char*      data_;
+  const Header*             header_;
+  const Format_Entry*       format_entries_;
+  const Translation_Entry*  translation_entries_;
+
+  // the lazily built formats and translations (null until first used)
+  std::unique_ptr<std::atomic<const format_type*>[]>       formats_;
+  std::unique_ptr<std::atomic<const translation_type*>[]>  translations_;
+  mutable std::mutex                                       mutex_;
+
+public:
+  // ctor: view the catalog in the block of memory (which must be aligned
+  // to eight bytes, as memory from mmap or operator new is)
+  Basic_Catalog(const void* data, const size_type size);
+  ~Basic_Catalog();
+
+  Basic_Catalog(const Basic_Catalog&) = delete;
+  Basic_Catalog& operator=(const Basic_Catalog&) = delete;
+
+  // return errc::catalog if the ctor would throw with these arguments, or
+  // errc::ok otherwise (without allocating)
+  static errc validate(const void* data, const size_type size) noexcept;
+
+  // return the block of a catalog of the formats and translations (as a
+  // string of bytes, ready to be written to a file)
+  static std::string compile(const format_map& formats,
+                             const translation_map& translations
+                                                     = translation_map());
+
+  // the numbers of formats and translations
+  size_type formats() const;
+  size_type translations() const;
+
+  // the name of the format or translation with the given index (the
+  // entries are in the order of their names), and the index of the one
+  // with the given name (or npos if there is none)
+  string    format_name(const size_type) const;
+  string    translation_name(const size_type) const;
+  size_type find_format(const string&) const;
+  size_type find_translation(const string&) const;
+
+  // the digits of a format, in place
+  digits_view digits(const size_type) const;
+  digits_view exponent_digits(const size_type) const;
+
+  // return the format with the given index, or name (nullptr if there is
+  // none), building it if need be
+  const format_type& format(const size_type) const;
+  const format_type* format(const string&) const;
+
+  // return the translation with the given index, or name (nullptr if there
+  // is none), building its set of congruences if need be
+  const translation_type& translation(const size_type) const;
+  const translation_type* translation(const string&) const;
+
+  // translate the input with the translation with the given index, reading
+  // its characters in place (so, without building the set)
+  string translate(const size_type, const string&) const;
+
+protected:
+  template <typename TEntry>
+  size_type raw_find(const TEntry*, const size_type, const string&) const;
+  const char_type* raw_chars(const std::uint64_t) const;
+
+  // does the block (of the given size) hold count objects of the given
+  // size from the offset, which must be aligned to eight bytes
+  static bool raw_span(const size_type size, const std::uint64_t offset,
+                       const std::uint64_t count,
+                       const std::uint64_t unit) noexcept;
+
+  // compare two strings held in the block (as std::basic_string::compare)
+  static int raw_compare(const char_type*, const std::uint64_t,
+                         const char_type*, const std::uint64_t) noexcept;
+
+  // the FNV-1a hash of the bytes (a multiple of eight of them)
+  static std::uint64_t raw_checksum(const unsigned char*,
+                                    const unsigned char*) noexcept;
+};
+
+
+
+/** class Catalog_File
+ *
+ * class maps a catalog file into memory, read-only, so that a
+ * Basic_Catalog can view it: the file's pages are shared by all the
+ * processes that map it, and nothing is copied. (Where the system has no
+ * mmap, the file is read into memory instead.) The ctor throws a
+ * std::system_error if the file cannot be opened or mapped.
+ *
+ */
+class Catalog_File {
+  void*        data_;
+  std::size_t  size_;
+  bool         mapped_;
+
+public:
+  explicit Catalog_File(const std::string& path);
+  ~Catalog_File();
+
+  Catalog_File(const Catalog_File&) = delete;
+  Catalog_File& operator=(const Catalog_File&) = delete;
+
+  const void*  data() const;
+  std::size_t  size() const;
+};
+
+
+
+/** enum class Parse_State
+ *
+ * the state of a Basic_Push_Parser after it has been fed some input:
+ *   viable    - the input is not a number, but may yet become one
+ *   complete  - the input is a number (and more input may or may not keep
+ *               it one)
+ *   invalid   - no further input can make it a number
+ *
+ */
+enum class Parse_State { viable, complete, invalid };
+
+
+
+/** class Basic_Push_Parser
+ *
+ * class validates a number against a format as its characters arrive, one
+ * at a time or in chunks, rather than all at once as `compare' does. Each
+ * feed is examined once, so feeding a field a character at a time costs
+ * no more than comparing it once at the end, and input that can never be
+ * a number is caught at the first bad character, after which the rest is
+ * not even kept:
+ *
+ *   Arithmos::Push_Parser p(Arithmos::hexadecimal);
+ *   p.feed("0x1f");      // Parse_State::complete
+ *   p.feed("p");         // Parse_State::viable (an exponent must follow)
+ *   p.feed("-2");        // Parse_State::complete
+ *   Arithmos::Data d = p.finish();
+ *
+ * The parser agrees with `compare': the state is complete exactly when
+ * `compare' would find the input so far to be a number, and `finish'
+ * returns what `compare' would. The format must outlive the parser.
+ * Feeding a parser that has been reset allocates nothing until the input
+ * grows longer than any it has held before.
+ *
+ */
+template <typename TChar, typename TCounter = count_type>
+class Basic_Push_Parser {
+public:
+  typedef Basic_Format<TChar,TCounter>       format_type;
+  typedef typename format_type::char_type    char_type;
+  typedef typename format_type::count_type   count_type;
+  typedef typename format_type::string       string;
+  typedef Basic_Data<char_type>              data_type;
+
+private:
+  typedef typename format_type::Lookup       lookup_type;
+  typedef typename format_type::Groups       groups_type;
+
+  // where in the generic format the next character falls (see
+  // Basic_Format): the sign, the specifier, the digits, the exponent's
+  // sign, or the exponent's digits
+  enum class Part { sign, specifier, digits, exponent_sign,
+                    exponent_digits };
+
+  const format_type&  format_;
+  lookup_type         whole_;
+  lookup_type         exponent_;
+  string              input_;
+  Parse_State         state_;
+  Part                part_;
+  std::size_t         specifier_matched_;
+  std::size_t         digits_;      // digits seen (including a point)
+  bool                point_only_;  // are the digits just a point
+  bool                decimal_;     // has the point been seen
+  groups_type         groups_;      // the digit-group separators seen
+  std::size_t         pending_;     // the trailing characters that may
+                                    // begin the exponent string
+  std::size_t         exponent_digits_;
+
+public:
+  // ctor
+  explicit Basic_Push_Parser(const format_type&);
+
+  // feed more of the input, returning the state of all the input so far
+  Parse_State feed(const char_type);
+  Parse_State feed(const string&);
+  Parse_State feed(const char_type* first, const char_type* last);
+
+  // the state of the input so far
+  Parse_State state() const;
+
+  // the input so far (up to and including the first invalid character)
+  const string& input() const;
+
+  // the data on the input so far (as returned by compare)
+  data_type finish() const;
+
+  // start again with no input
+  void reset();
+
+protected:
+  Parse_State raw_feed(const char_type);
+  bool        raw_digit(const char_type);
+  bool        raw_pending_digits() const;
+  bool        raw_viable() const;
+  Parse_State raw_state() const;
 };
 
 
+
 // typedef some useful templated classes
 typedef  Basic_Congruence<char>                               Congruence;
 typedef  std::unordered_set<Congruence>                       Translation;
 typedef  Basic_Format<char, count_type>                       Format;
 typedef  Basic_Data<Format::char_type>                        Data;
+typedef  Basic_Batch<Format::char_type>                       Batch;
 typedef  Basic_Digit<Format::char_type, Format::count_type>   Digit;
+typedef  Basic_Predefined_Digits<char, count_type>            Predefined_Digits;
+typedef  Basic_Predefined_Format<char, count_type>            Predefined_Format;
+typedef  Basic_Predefined_Translation<char>                   Predefined_Translation;
+typedef  Basic_Cached_Format<char, count_type>                Cached_Format;
+typedef  Basic_Numeric_Less<char, count_type>                 Numeric_Less;
+typedef  Basic_Format_Registry<char, count_type>              Format_Registry;
+typedef  Basic_Catalog<char, count_type>                      Catalog;
+typedef  Basic_Push_Parser<char, count_type>                  Push_Parser;
 
 typedef  Basic_Congruence<wchar_t>                            WCongruence;
 typedef  std::unordered_set<WCongruence>                      WTranslation;
 typedef  Basic_Format<wchar_t, count_type>                    WFormat;
 typedef  Basic_Data<WFormat::char_type>                       WData;
+typedef  Basic_Batch<WFormat::char_type>                      WBatch;
 typedef  Basic_Digit<WFormat::char_type, WFormat::count_type> WDigit;
+typedef  Basic_Predefined_Digits<wchar_t, count_type>         WPredefined_Digits;
+typedef  Basic_Predefined_Format<wchar_t, count_type>         WPredefined_Format;
+typedef  Basic_Predefined_Translation<wchar_t>                WPredefined_Translation;
+typedef  Basic_Cached_Format<wchar_t, count_type>             WCached_Format;
+typedef  Basic_Numeric_Less<wchar_t, count_type>              WNumeric_Less;
+typedef  Basic_Format_Registry<wchar_t, count_type>           WFormat_Registry;
+typedef  Basic_Catalog<wchar_t, count_type>                   WCatalog;
+typedef  Basic_Push_Parser<wchar_t, count_type>               WPush_Parser;
 
 #ifdef __cpp_char8_t
 typedef  Basic_Congruence<char8_t>                            U8Congruence;
 typedef  std::unordered_set<U8Congruence>                     U8Translation;
 typedef  Basic_Format<char8_t, count_type>                    U8Format;
 typedef  Basic_Data<U8Format::char_type>                      U8Data;
+typedef  Basic_Batch<U8Format::char_type>                     U8Batch;
 typedef  Basic_Digit<U8Format::char_type, U8Format::count_type> U8Digit;
+typedef  Basic_Predefined_Digits<char8_t, count_type>         U8Predefined_Digits;
+typedef  Basic_Predefined_Format<char8_t, count_type>         U8Predefined_Format;
+typedef  Basic_Predefined_Translation<char8_t>                U8Predefined_Translation;
+typedef  Basic_Cached_Format<char8_t, count_type>             U8Cached_Format;
+typedef  Basic_Numeric_Less<char8_t, count_type>              U8Numeric_Less;
+typedef  Basic_Format_Registry<char8_t, count_type>           U8Format_Registry;
+typedef  Basic_Catalog<char8_t, count_type>                   U8Catalog;
+typedef  Basic_Push_Parser<char8_t, count_type>               U8Push_Parser;
 #endif // __cpp_char8_t
 
 typedef  Basic_Congruence<char16_t>                           U16Congruence;
 typedef  std::unordered_set<U16Congruence>                    U16Translation;
 typedef  Basic_Format<char16_t, count_type>                   U16Format;
 typedef  Basic_Data<U16Format::char_type>                     U16Data;
+typedef  Basic_Batch<U16Format::char_type>                    U16Batch;
 typedef  Basic_Digit<U16Format::char_type, U16Format::count_type> U16Digit;
+typedef  Basic_Predefined_Digits<char16_t, count_type>        U16Predefined_Digits;
+typedef  Basic_Predefined_Format<char16_t, count_type>        U16Predefined_Format;
+typedef  Basic_Predefined_Translation<char16_t>               U16Predefined_Translation;
+typedef  Basic_Cached_Format<char16_t, count_type>            U16Cached_Format;
+typedef  Basic_Numeric_Less<char16_t, count_type>             U16Numeric_Less;
+typedef  Basic_Format_Registry<char16_t, count_type>          U16Format_Registry;
+typedef  Basic_Catalog<char16_t, count_type>                  U16Catalog;
+typedef  Basic_Push_Parser<char16_t, count_type>              U16Push_Parser;
 
 typedef  Basic_Congruence<char32_t>                           U32Congruence;
 typedef  std::unordered_set<U32Congruence>                    U32Translation;
 typedef  Basic_Format<char32_t, count_type>                   U32Format;
 typedef  Basic_Data<U32Format::char_type>                     U32Data;
+typedef  Basic_Batch<U32Format::char_type>                    U32Batch;
 typedef  Basic_Digit<U32Format::char_type, U32Format::count_type> U32Digit;
+typedef  Basic_Predefined_Digits<char32_t, count_type>        U32Predefined_Digits;
+typedef  Basic_Predefined_Format<char32_t, count_type>        U32Predefined_Format;
+typedef  Basic_Predefined_Translation<char32_t>               U32Predefined_Translation;
+typedef  Basic_Cached_Format<char32_t, count_type>            U32Cached_Format;
+typedef  Basic_Numeric_Less<char32_t, count_type>             U32Numeric_Less;
+typedef  Basic_Format_Registry<char32_t, count_type>          U32Format_Registry;
+typedef  Basic_Catalog<char32_t, count_type>                  U32Catalog;
+typedef  Basic_Push_Parser<char32_t, count_type>              U32Push_Parser;
 
 } // namespace Arithmos
 
@@ -505,82 +2389,178 @@ typedef  Basic_Digit<U32Format::char_type, U32Format::count_type> U32Digit;
 #include "arithmos.tcc"
 
 
+// the library (see arithmos.cpp) contains an explicit instantiation of the
+// templated classes and functions for the shipped character types, compiled
+// with the configure-time optimization flags; declare them here so that
+// every translation unit that includes this header uses those copies rather
+// than instantiating its own. Define LIBARITHMOS_NO_EXTERN_TEMPLATES before
+// including this header to instantiate them locally instead (as when using
+// the header without linking to the library).
+//
+// Note: the char8_t classes are not declared here as the library need not
+// have been compiled with a C++20 compiler.
+#ifndef LIBARITHMOS_NO_EXTERN_TEMPLATES
+namespace Arithmos {
+
+extern template class  Basic_Congruence<char>;
+extern template class  Basic_Digit<char, count_type>;
+extern template class  Basic_Format<char, count_type>;
+extern template struct Basic_Data<char>;
+extern template struct Basic_Batch<char>;
+extern template class  Basic_Cached_Format<char, count_type>;
+extern template class  Basic_Numeric_Less<char, count_type>;
+extern template class  Basic_Format_Registry<char, count_type>;
+extern template class  Basic_Catalog<char, count_type>;
+extern template class  Basic_Push_Parser<char, count_type>;
+
+extern template class  Basic_Congruence<wchar_t>;
+extern template class  Basic_Digit<wchar_t, count_type>;
+extern template class  Basic_Format<wchar_t, count_type>;
+extern template struct Basic_Data<wchar_t>;
+extern template struct Basic_Batch<wchar_t>;
+extern template class  Basic_Cached_Format<wchar_t, count_type>;
+extern template class  Basic_Numeric_Less<wchar_t, count_type>;
+extern template class  Basic_Format_Registry<wchar_t, count_type>;
+extern template class  Basic_Catalog<wchar_t, count_type>;
+extern template class  Basic_Push_Parser<wchar_t, count_type>;
+
+extern template class  Basic_Congruence<char16_t>;
+extern template class  Basic_Digit<char16_t, count_type>;
+extern template class  Basic_Format<char16_t, count_type>;
+extern template struct Basic_Data<char16_t>;
+extern template struct Basic_Batch<char16_t>;
+extern template class  Basic_Cached_Format<char16_t, count_type>;
+extern template class  Basic_Numeric_Less<char16_t, count_type>;
+extern template class  Basic_Format_Registry<char16_t, count_type>;
+extern template class  Basic_Catalog<char16_t, count_type>;
+extern template class  Basic_Push_Parser<char16_t, count_type>;
+
+extern template class  Basic_Congruence<char32_t>;
+extern template class  Basic_Digit<char32_t, count_type>;
+extern template class  Basic_Format<char32_t, count_type>;
+extern template struct Basic_Data<char32_t>;
+extern template struct Basic_Batch<char32_t>;
+extern template class  Basic_Cached_Format<char32_t, count_type>;
+extern template class  Basic_Numeric_Less<char32_t, count_type>;
+extern template class  Basic_Format_Registry<char32_t, count_type>;
+extern template class  Basic_Catalog<char32_t, count_type>;
+extern template class  Basic_Push_Parser<char32_t, count_type>;
+
+extern template struct Column<std::int64_t>;
+extern template struct Column<std::uint64_t>;
+extern template struct Column<double>;
+
+extern template std::basic_string<char> translate(
+    const std::basic_string<char>&,
+    const std::unordered_set<Basic_Congruence<char>>&);
+
+extern template std::basic_string<wchar_t> translate(
+    const std::basic_string<wchar_t>&,
+    const std::unordered_set<Basic_Congruence<wchar_t>>&);
+
+extern template std::basic_string<char16_t> translate(
+    const std::basic_string<char16_t>&,
+    const std::unordered_set<Basic_Congruence<char16_t>>&);
+
+extern template std::basic_string<char32_t> translate(
+    const std::basic_string<char32_t>&,
+    const std::unordered_set<Basic_Congruence<char32_t>>&);
+
+} // namespace Arithmos
+#endif // LIBARITHMOS_NO_EXTERN_TEMPLATES
+
+
 namespace Arithmos {
 
 // some pre-defined translations
-extern const Translation  hex_lower_to_upper;
-extern const Translation  hex_upper_to_lower;
+extern const Predefined_Translation  hex_lower_to_upper;
+extern const Predefined_Translation  hex_upper_to_lower;
 
-extern const WTranslation whex_lower_to_upper;
-extern const WTranslation whex_upper_to_lower;
+extern const WPredefined_Translation whex_lower_to_upper;
+extern const WPredefined_Translation whex_upper_to_lower;
 
 #ifdef __cpp_char8_t
-extern const U8Translation  u8hex_lower_to_upper;
-extern const U8Translation  u8hex_upper_to_lower;
+extern const U8Predefined_Translation  u8hex_lower_to_upper;
+extern const U8Predefined_Translation  u8hex_upper_to_lower;
 #endif // __cpp_char8_t
 
-extern const U16Translation  u16hex_lower_to_upper;
-extern const U16Translation  u16hex_upper_to_lower;
+extern const U16Predefined_Translation  u16hex_lower_to_upper;
+extern const U16Predefined_Translation  u16hex_upper_to_lower;
 
-extern const U32Translation  u32hex_lower_to_upper;
-extern const U32Translation  u32hex_upper_to_lower;
+extern const U32Predefined_Translation  u32hex_lower_to_upper;
+extern const U32Predefined_Translation  u32hex_upper_to_lower;
 
 // some pre-defined number formats
-extern const std::vector<Digit> binary_digits;
-extern const std::vector<Digit> octal_digits;
-extern const std::vector<Digit> decimal_digits;
-extern const std::vector<Digit> hexadecimal_digits;
+extern const Predefined_Digits binary_digits;
+extern const Predefined_Digits octal_digits;
+extern const Predefined_Digits decimal_digits;
+extern const Predefined_Digits hexadecimal_digits;
 
-extern const std::vector<WDigit> wbinary_digits;
-extern const std::vector<WDigit> woctal_digits;
-extern const std::vector<WDigit> wdecimal_digits;
-extern const std::vector<WDigit> whexadecimal_digits;
+extern const WPredefined_Digits wbinary_digits;
+extern const WPredefined_Digits woctal_digits;
+extern const WPredefined_Digits wdecimal_digits;
+extern const WPredefined_Digits whexadecimal_digits;
 
 #ifdef __cpp_char8_t
-extern const std::vector<U8Digit> u8binary_digits;
-extern const std::vector<U8Digit> u8octal_digits;
-extern const std::vector<U8Digit> u8decimal_digits;
-extern const std::vector<U8Digit> u8hexadecimal_digits;
+extern const U8Predefined_Digits u8binary_digits;
+extern const U8Predefined_Digits u8octal_digits;
+extern const U8Predefined_Digits u8decimal_digits;
+extern const U8Predefined_Digits u8hexadecimal_digits;
 #endif // __cpp_char8_t
 
-extern const std::vector<U16Digit> u16binary_digits;
-extern const std::vector<U16Digit> u16octal_digits;
-extern const std::vector<U16Digit> u16decimal_digits;
-extern const std::vector<U16Digit> u16hexadecimal_digits;
+extern const U16Predefined_Digits u16binary_digits;
+extern const U16Predefined_Digits u16octal_digits;
+extern const U16Predefined_Digits u16decimal_digits;
+extern const U16Predefined_Digits u16hexadecimal_digits;
 
-extern const std::vector<U32Digit> u32binary_digits;
-extern const std::vector<U32Digit> u32octal_digits;
-extern const std::vector<U32Digit> u32decimal_digits;
-extern const std::vector<U32Digit> u32hexadecimal_digits;
+extern const U32Predefined_Digits u32binary_digits;
+extern const U32Predefined_Digits u32octal_digits;
+extern const U32Predefined_Digits u32decimal_digits;
+extern const U32Predefined_Digits u32hexadecimal_digits;
 
-extern const Format  binary;
-extern const Format  octal;
-extern const Format  decimal;
-extern const Format  hexadecimal;
+extern const Predefined_Format  binary;
+extern const Predefined_Format  octal;
+extern const Predefined_Format  decimal;
+extern const Predefined_Format  hexadecimal;
 
-extern const WFormat  wbinary;
-extern const WFormat  woctal;
-extern const WFormat  wdecimal;
-extern const WFormat  whexadecimal;
+extern const WPredefined_Format  wbinary;
+extern const WPredefined_Format  woctal;
+extern const WPredefined_Format  wdecimal;
+extern const WPredefined_Format  whexadecimal;
 
 #ifdef __cpp_char8_t
-extern const U8Format  u8binary;
-extern const U8Format  u8octal;
-extern const U8Format  u8decimal;
-extern const U8Format  u8hexadecimal;
+extern const U8Predefined_Format  u8binary;
+extern const U8Predefined_Format  u8octal;
+extern const U8Predefined_Format  u8decimal;
+extern const U8Predefined_Format  u8hexadecimal;
 #endif // __cpp_char8_t
 
-extern const U16Format  u16binary;
-extern const U16Format  u16octal;
-extern const U16Format  u16decimal;
-extern const U16Format  u16hexadecimal;
+extern const U16Predefined_Format  u16binary;
+extern const U16Predefined_Format  u16octal;
+extern const U16Predefined_Format  u16decimal;
+extern const U16Predefined_Format  u16hexadecimal;
 
-extern const U32Format  u32binary;
-extern const U32Format  u32octal;
-extern const U32Format  u32decimal;
-extern const U32Format  u32hexadecimal;
+extern const U32Predefined_Format  u32binary;
+extern const U32Predefined_Format  u32octal;
+extern const U32Predefined_Format  u32decimal;
+extern const U32Predefined_Format  u32hexadecimal;
 
 
 } // namespace Arithmos
 
+
+
+namespace std {
+  // we'll also specialize the hash struct for numeric values:
+  template <>
+  struct hash<Arithmos::Numeric_Value> {
+    typedef Arithmos::Numeric_Value  argument_type;
+    typedef size_t  result_type;
+
+    result_type operator() (const argument_type& t) const {
+      return t.hash();
+    }
+  };
+}
+
 #endif // LIBARITHMOS_H
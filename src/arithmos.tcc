@@ -35,8 +35,14 @@ template <typename TChar>
 Basic_Congruence<TChar>::Basic_Congruence(const set& s, const char_type d)
   : set_{s}, default_{d}
 {
-  if ( set_.find(d) == set_.end() )
-    throw congruence_not_in_set();
+  if ( validate(s, d) != errc::ok )
+    LIBARITHMOS_THROW(congruence_not_in_set());
+}
+
+template <typename TChar>
+errc Basic_Congruence<TChar>::validate(const set& s, const char_type d)
+    noexcept {
+  return s.find(d) == s.end() ? errc::not_in_set : errc::ok;
 }
 
 template <typename TChar>
@@ -67,6 +73,11 @@ bool Basic_Congruence<TChar>::has(const char_type t) const {
   return set_.find(t) != set_.end();
 }
 
+template <typename TChar>
+auto Basic_Congruence<TChar>::get_set() const -> const set& {
+  return set_;
+}
+
 
 
 
@@ -99,13 +110,13 @@ translate(const std::basic_string<T>& input,
 // -- class Basic_Digit --------------
 // ctor: Basic_Digit(const char_type, const count_type)
 template <typename T, typename U>
-Basic_Digit<T,U>::Basic_Digit(const char_type name,
-                              const count_type count_max)
+constexpr Basic_Digit<T,U>::Basic_Digit(const char_type name,
+                                        const count_type count_max)
   : name_{name}, count_max_{count_max} {}
 
 // ctor: Basic_Digit(const char_type)
 template <typename T, typename U>
-Basic_Digit<T,U>::Basic_Digit(const char_type name)
+constexpr Basic_Digit<T,U>::Basic_Digit(const char_type name)
   : Basic_Digit{name, static_cast<count_type>(-1)} {}
 
 // operator==(const Basic_Digit&)
@@ -134,13 +145,13 @@ bool Basic_Digit<T,U>::operator!=(const char_type d) const {
 
 // get name
 template <typename T, typename U>
-auto Basic_Digit<T,U>::name() const -> char_type {
+constexpr auto Basic_Digit<T,U>::name() const -> char_type {
   return name_;
 }
 
 // get count max
 template <typename T, typename U>
-auto Basic_Digit<T,U>::count_max() const -> count_type {
+constexpr auto Basic_Digit<T,U>::count_max() const -> count_type {
   return count_max_;
 }
 
@@ -148,6 +159,49 @@ auto Basic_Digit<T,U>::count_max() const -> count_type {
 
 
 
+// -- class Basic_Predefined_Digits --------------
+// ctor: Basic_Predefined_Digits(const digit_type (&)[N])
+template <typename T, typename U>
+template <std::size_t N>
+constexpr Basic_Predefined_Digits<T,U>::Basic_Predefined_Digits
+    (const digit_type (&digits)[N])
+  : digits_{digits}, size_{N} {}
+
+template <typename T, typename U>
+constexpr Basic_Predefined_Digits<T,U>::Basic_Predefined_Digits
+    (const digit_type* digits, const size_type size)
+  : digits_{digits}, size_{size} {}
+
+template <typename T, typename U>
+auto Basic_Predefined_Digits<T,U>::begin() const -> const_iterator {
+  return digits_;
+}
+
+template <typename T, typename U>
+auto Basic_Predefined_Digits<T,U>::end() const -> const_iterator {
+  return digits_ + size_;
+}
+
+template <typename T, typename U>
+auto Basic_Predefined_Digits<T,U>::size() const -> size_type {
+  return size_;
+}
+
+template <typename T, typename U>
+auto Basic_Predefined_Digits<T,U>::operator[](const size_type i) const
+    -> const digit_type& {
+  return digits_[i];
+}
+
+template <typename T, typename U>
+Basic_Predefined_Digits<T,U>::operator digits_type() const {
+  return digits_type(begin(), end());
+}
+
+
+
+
+
 // -- struct Basic_Data --------------
 // ctor: Basic_Data()
 template <typename T>
@@ -174,6 +228,32 @@ Basic_Data<T>::Basic_Data()
     normalized                    {}
   {}
 
+// clear: as assigning a default Basic_Data, but the strings are cleared
+// rather than replaced, so that their capacity is kept for the next parse
+template <typename T>
+void Basic_Data<T>::clear() {
+  is_number                     = false;
+  is_integer                    = false;
+  is_integer_literal            = true;
+  has_decimal                   = false;
+  has_decimal_literal           = false;
+  is_fraction_by_exponent       = false;
+  is_zero                       = false;
+  is_positive                   = true;
+  is_explicit_positive          = false;
+  is_exponent_positive          = true;
+  is_exponent_explicit_positive = false;
+  whole_width                   = 0;
+  exponent_width                = 0;
+  mantissa                      = 0;
+  whole_string.clear();
+  whole_string_normalized.clear();
+  exponent_position             = string::npos;
+  exponent_string.clear();
+  exponent_string_normalized.clear();
+  normalized.clear();
+}
+
 // declare == operator
 template <typename T>
 bool Basic_Data<T>::operator==(const Basic_Data<T>& d) const {
@@ -209,6 +289,70 @@ bool Basic_Data<T>::operator!=(const Basic_Data<T>& d) const {
 
 
 
+// -- struct Column --------------
+// ctor: Column()
+template <typename V>
+Column<V>::Column()
+  : values     {},
+    validity   {},
+    null_count {0},
+    rejected   {}
+{}
+
+template <typename V>
+std::size_t Column<V>::size() const {
+  return values.size();
+}
+
+template <typename V>
+bool Column<V>::is_valid(const std::size_t row) const {
+  return (validity[row / 8] >> (row % 8)) & 1;
+}
+
+
+
+
+
+// -- struct Basic_Batch --------------
+// ctor: Basic_Batch()
+template <typename T>
+Basic_Batch<T>::Basic_Batch()
+  : buffer     {},
+    offsets    (1, 0),
+    validity   {},
+    null_count {0},
+    rejected   {}
+{}
+
+template <typename T>
+std::size_t Basic_Batch<T>::size() const {
+  return offsets.size() - 1;
+}
+
+template <typename T>
+bool Basic_Batch<T>::is_valid(const std::size_t row) const {
+  return (validity[row / 8] >> (row % 8)) & 1;
+}
+
+template <typename T>
+auto Basic_Batch<T>::data(const std::size_t row) const -> const char_type* {
+  return buffer.data() + offsets[row];
+}
+
+template <typename T>
+std::size_t Basic_Batch<T>::length(const std::size_t row) const {
+  return offsets[row + 1] - offsets[row];
+}
+
+template <typename T>
+auto Basic_Batch<T>::get(const std::size_t row) const -> string {
+  return buffer.substr(offsets[row], length(row));
+}
+
+
+
+
+
 // -- struct Basic_Format::Split -------------
 // ctor: Split()
 template <typename T, typename U>
@@ -229,6 +373,123 @@ template <typename T, typename U>
 Basic_Format<T,U>::Count::Count(const count_type max)
   : count_list_(max, count_type(0)) {}
 
+template <typename T, typename U>
+void Basic_Format<T,U>::Count::reset(const count_type max) {
+  count_list_.assign(max, count_type(0));
+}
+
+
+
+// -- class Basic_Format::Context -------------
+// ctor: Context()
+template <typename T, typename U>
+Basic_Format<T,U>::Context::Context()
+  : digit_count_     {0},
+    exp_digit_count_ {0},
+    data_            {},
+    split_           {},
+    other_           {},
+    lhs_             {},
+    rhs_             {},
+    result_          {}
+  {}
+
+
+
+// -- struct Basic_Format::Groups -------------
+// ctor: Groups(const std::size_t)
+template <typename T, typename U>
+Basic_Format<T,U>::Groups::Groups(const std::size_t width)
+  : width_     {width},
+    count_     {0},
+    separated_ {false}
+{}
+
+template <typename T, typename U>
+void Basic_Format<T,U>::Groups::digit() {
+  ++count_;
+}
+
+// separator: the group before a separator must not be empty and, if it is
+// not the first, must be full; the first may be shorter, but no longer
+template <typename T, typename U>
+bool Basic_Format<T,U>::Groups::separator() {
+  if ( count_ == 0 ||
+       (separated_ ? width_ != 0 && count_ != width_ :
+                     width_ != 0 && count_ > width_) )
+    return false;
+  separated_ = true;
+  count_ = 0;
+  return true;
+}
+
+template <typename T, typename U>
+bool Basic_Format<T,U>::Groups::end() const {
+  return !separated_ || (count_ != 0 && (width_ == 0 || count_ == width_));
+}
+
+
+
+// -- struct Basic_Format::Scientific -------------
+// ctor: Scientific()
+template <typename T, typename U>
+Basic_Format<T,U>::Scientific::Scientific()
+  : zero     {true},
+    positive {true},
+    exponent {0},
+    scale    {0},
+    digits   {}
+{}
+
+
+
+// -- struct Basic_Format::Lookup -------------
+template <typename T, typename U>
+const std::size_t Basic_Format<T,U>::Lookup::npos;
+
+// ctor: Lookup(const digits_type&)
+template <typename T, typename U>
+Basic_Format<T,U>::Lookup::Lookup(const digits_type& digits)
+  : digits_     (digits),
+    table_      {},
+    count_list_ (digits.size(), count_type(0)),
+    limited_    {false}
+{
+  std::fill(table_, table_ + 256, npos);
+  // fill the table from the back, so the first of any repeated digits
+  // wins (as it does in compare)
+  for (std::size_t i = digits.size(); i-- > 0; ) {
+    const auto c = static_cast<typename std::make_unsigned<T>::type>(
+                                                        digits[i].name());
+    if (c < 256)
+      table_[c] = i;
+    if (digits[i].count_max() != static_cast<count_type>(-1))
+      limited_ = true;
+  }
+}
+
+template <typename T, typename U>
+std::size_t Basic_Format<T,U>::Lookup::find(const char_type c) const {
+  const auto u = static_cast<typename std::make_unsigned<T>::type>(c);
+  if (u < 256)
+    return table_[u];
+  for (std::size_t i = 0; i < digits_.size(); ++i)
+    if (digits_[i] == c)
+      return i;
+  return npos;
+}
+
+template <typename T, typename U>
+bool Basic_Format<T,U>::Lookup::count(const std::size_t i) {
+  return !limited_ || ++count_list_[i] <= digits_[i].count_max();
+}
+
+template <typename T, typename U>
+void Basic_Format<T,U>::Lookup::reset() {
+  if (limited_)
+    std::fill(count_list_.begin(), count_list_.end(), count_type(0));
+}
+
 
 
 // -- class Basic_Format --------------
@@ -237,15 +498,58 @@ template <typename T, typename U>
 Basic_Format<T,U>::Basic_Format(const string&       specifier,
                                 const digits_type&  digits,
                                 const string&       exp_string,
-                                const digits_type&  exp_digits)
+                                const digits_type&  exp_digits,
+                                const Symbols&      symbols)
   : specifier_  {specifier},
     digits_     {digits},
     exp_        {exp_string},
-    exp_digits_ {exp_digits}
+    exp_digits_ {exp_digits},
+    symbols_    (symbols)
 {
+  if ( validate(digits, exp_digits, symbols) != errc::ok )
+    LIBARITHMOS_THROW(invalid_format());
+  digits_.push_back(digit_type(symbols_.point,1)); // FIXME: better way?
+}
+
+// validate: can a format be constructed with these digits and symbols (a
+// format needs at least two digits and two exponent digits, and none of the
+// symbols may be a digit, nor the separator another symbol)
+template <typename T, typename U>
+errc Basic_Format<T,U>::validate(const digits_type& digits,
+                                 const digits_type& exp_digits,
+                                 const Symbols& symbols) noexcept {
+  return raw_validate(digits, exp_digits, symbols);
+}
+
+template <typename T, typename U>
+errc Basic_Format<T,U>::validate
+    (const Basic_Predefined_Digits<char_type,count_type>& digits,
+     const Basic_Predefined_Digits<char_type,count_type>& exp_digits,
+     const Symbols& symbols) noexcept {
+  return raw_validate(digits, exp_digits, symbols);
+}
+
+// raw_validate: validate, for any list of digits (a vector or a view)
+template <typename T, typename U>
+template <typename TDigits>
+errc Basic_Format<T,U>::raw_validate(const TDigits& digits,
+                                     const TDigits& exp_digits,
+                                     const Symbols& symbols) noexcept {
   if ( digits.size() < 2 || exp_digits.size() < 2 )
-    throw invalid_format();
-  digits_.push_back(digit_type(char_type('.'),1)); // FIXME: better way?
+    return errc::invalid_format;
+  for (auto i = digits.begin(); i != digits.end(); ++i)
+    if ( *i == symbols.point || *i == symbols.plus || *i == symbols.minus ||
+         (symbols.separator != char_type(0) && *i == symbols.separator) )
+      return errc::invalid_format;
+  for (auto i = exp_digits.begin(); i != exp_digits.end(); ++i)
+    if ( *i == symbols.plus || *i == symbols.minus )
+      return errc::invalid_format;
+  if ( symbols.separator != char_type(0) &&
+       (symbols.separator == symbols.point ||
+        symbols.separator == symbols.plus ||
+        symbols.separator == symbols.minus) )
+    return errc::invalid_format;
+  return errc::ok;
 }
 
 // get: specifier_
@@ -272,85 +576,180 @@ auto Basic_Format<T,U>::exponent_digits() const -> const digits_type& {
   return exp_digits_;
 }
 
+// get: symbols_
+template <typename T, typename U>
+auto Basic_Format<T,U>::symbols() const -> const Symbols& {
+  return symbols_;
+}
+
 // compare method:
 //   Basic_Data<T> compare(const string& str)
 //
+// compare is parse (below) without the reason for a string not being a
+// number.
+template <typename T, typename U>
+Basic_Data<T> Basic_Format<T,U>::compare(const string& str) const {
+  Basic_Data<T> data;
+  parse(str, data);
+  return data;
+}
+
+// parse method:
+//   Status parse(const string& str, Basic_Data<T>& data)
+//
 // This member function will examine str to see whether it conforms to the
 // number format described by the class and also record other properties of
 // it concerning its interpretation as a number. It will function by moving
 // sequentially through the string interpreting each character it meets by
 // comparing it to what should be found at that point in the string as set
 // out by the class's data members, who describe the format the number must
-// conform to.
+// conform to. If str is not a number, data is reset (to a default
+// Basic_Data) and the error returned says why, and where: the position of
+// the first character that could not be accepted, or the length of the
+// string if something is missing from its end. Every index used below has
+// been checked against the length of the string or of the digit lists, so
+// no checked accessors are needed.
 template <typename T, typename U>
-Basic_Data<T> Basic_Format<T,U>::compare(const string& str) const {
-  // first, we'll exit if the string is empty
-  if (str.empty())
-    return {};
+Status Basic_Format<T,U>::parse(const string& str,
+                                Basic_Data<T>& data) const noexcept {
+  Context context;
+  return raw_parse(str, data, context);
+}
+
+template <typename T, typename U>
+Status Basic_Format<T,U>::parse(const string& str, Basic_Data<T>& data,
+                                const Limits& limits) const noexcept {
+  Context context;
+  return raw_parse(str, data, context, limits);
+}
+
+// compare_into method:
+//   void compare_into(const string& str, Basic_Data<T>& data)
+//
+// compare, into an existing Basic_Data (parse clears rather than replaces
+// its strings, so their capacity is reused)
+template <typename T, typename U>
+void Basic_Format<T,U>::compare_into(const string& str,
+                                     Basic_Data<T>& data) const {
+  parse(str, data);
+}
+
+template <typename T, typename U>
+void Basic_Format<T,U>::compare_into(const string& str,
+                                     Basic_Data<T>& data,
+                                     Context& context) const {
+  raw_parse(str, data, context);
+}
+
+// raw_parse: parse, with the digit counts kept in the context. Nothing is
+// allocated below unless a string of data, or a list of counts, must grow
+// beyond the capacity it already has: strings are compared in place and
+// copied with assign. The string is read from the start, and no further
+// than the character at which it is rejected, so a string over one of the
+// limits is rejected after reading no more than the limit allows.
+template <typename T, typename U>
+Status Basic_Format<T,U>::raw_parse(const string& str,
+                                    Basic_Data<T>& data,
+                                    Context& context,
+                                    const Limits& limits) const noexcept {
+  data.clear();
+  // first, we'll exit if the string is empty, or too long
   const str_size_type str_length = str.length();
   if (str_length==0 || str_length==string::npos)
-    return {};
+    return raw_fail(data, errc::empty, 0);
+  if (limits.length != 0 && str_length > limits.length)
+    return raw_fail(data, errc::length_limit, limits.length);
 
   // look for a pre-digit (+ or - sign)
-  Basic_Data<T> data;
   str_size_type str_index = 0;
-  if (str.at(str_index) == char_type('+')) {
+  if (str[str_index] == symbols_.plus) {
     data.is_explicit_positive = true;
     ++str_index;
   }
-  else if (str.at(str_index) == char_type('-')) {
+  else if (str[str_index] == symbols_.minus) {
     data.is_positive = false;
-    data.whole_string_normalized += str.at(str_index);
+    data.whole_string_normalized += str[str_index];
     ++str_index;
   }
 
   // look for a type specifier if the class records one.
   if ( !specifier_.empty() ) {
     const str_size_type specifier_length = specifier_.length();
-    if ( specifier_ != str.substr(str_index,specifier_length) )
-      return {};
+    if ( str.compare(str_index, specifier_length, specifier_) != 0 ) {
+      str_size_type i = 0;
+      while (str_index + i < str_length && i < specifier_length &&
+             str[str_index + i] == specifier_[i])
+        ++i;
+      return raw_fail(data, errc::specifier, str_index + i);
+    }
     str_index += specifier_length;
     data.whole_string_normalized += specifier_;
   }
   // at this point, whole_string_normalized is: [-][specifier]
 
 
-  // look for an exponent string and then examine all the digits between
-  // str_index and that exponent for conformity.
-  data.exponent_position = str.find(exp_, str_index);
+  // examine all the digits up to the exponent string (the first place it
+  // appears, found as the digits are read) for conformity. Digit-group
+  // separators are skipped (once their places are checked), so they are
+  // left out of the normalized string.
+  data.exponent_position = exp_.empty() ? str_index : string::npos;
   bool start = true;
-  Count digit_count{ digits_.size() };
+  std::size_t significant = 0;
+  Count& digit_count = context.digit_count_;
+  digit_count.reset(digits_.size());
+  Groups groups{ symbols_.group };
   for (;
-       str_index < (data.exponent_position == string::npos ?
-                    str_length : data.exponent_position);
+       str_index < str_length && data.exponent_position == string::npos;
        ++str_index) {
+    if ( str[str_index] == exp_[0] &&
+         str.compare(str_index, exp_.length(), exp_) == 0 ) {
+      data.exponent_position = str_index;
+      break;
+    }
+    if ( symbols_.separator != char_type(0) &&
+         str[str_index] == symbols_.separator ) {
+      if ( data.has_decimal_literal || !groups.separator() )
+        return raw_fail(data, errc::separator, str_index);
+      continue;
+    }
     bool found = false;
     for (auto j = digits_.begin(); j != digits_.end(); ++j) {
-      if ( *j == str.at(str_index) ) {
+      if ( *j == str[str_index] ) {
         found = true;
-        if ( digit_count.count_list_.at(j - digits_.begin())
+        if ( digit_count.count_list_[j - digits_.begin()]
                 >= j->count_max() )
-          return {};
+          return raw_fail(data, errc::digit_count, str_index);
+        if ( j->name() == symbols_.point ) {
+          if ( !groups.end() )
+            return raw_fail(data, errc::separator, str_index);
+        }
+        else if ( !data.has_decimal_literal )
+          groups.digit();
         // ignore all zeros that appear before any other digit:
         if ( j->name() != digits_.begin()->name() || !start ) {
-          if ( j->name() == char_type('.') ) {
+          if ( j->name() == symbols_.point ) {
             data.has_decimal_literal = true;
             if (start)
               // a decimal at the start, ".",  is normalized to "0." and
               // then we continue...
               data.whole_string_normalized += digits_.begin()->name();
           }
+          if ( j->name() != symbols_.point && limits.digits != 0 &&
+               ++significant > limits.digits )
+            return raw_fail(data, errc::digit_limit, str_index);
           start = false;
           data.whole_string_normalized += j->name();
         }
-        ++digit_count.count_list_.at(j - digits_.begin());
+        ++digit_count.count_list_[j - digits_.begin()];
         break;
       }
     }
     if (!found)
-      return {};
+      return raw_fail(data, errc::digit, str_index);
   }
-  data.whole_string = str.substr(0,str_index);
+  if ( !data.has_decimal_literal && !groups.end() )
+    return raw_fail(data, errc::separator, str_index);
+  data.whole_string.assign(str, 0, str_index);
 
   // First, let's deal with the decimals.
   // Let's begin by dealing with:
@@ -365,13 +764,11 @@ Basic_Data<T> Basic_Format<T,U>::compare(const string& str) const {
   // normalized whole string is reproduced by othe inputs, so check the form
   // of the raw whole string and NOT the form of the normalized whole string
   // to do the following check
-  if (data.whole_string ==
-       ((data.is_positive ?
-            (data.is_explicit_positive ? string(1,char_type('+')) : string()) :
-            string(1,char_type('-')))
-        .append(specifier_)
-        .append(1,char_type('.'))) )
-    return {};
+  const char_type sign = data.is_positive ?
+      (data.is_explicit_positive ? symbols_.plus : char_type(0)) :
+      symbols_.minus;
+  if ( raw_is(data.whole_string, sign, symbols_.point) )
+    return raw_fail(data, errc::lone_point, str_index - 1);
 
   // The only correction we've made is putting a zero before a decimal point
   // if there was not already one there, so let's begin normalizing the
@@ -380,12 +777,12 @@ Basic_Data<T> Basic_Format<T,U>::compare(const string& str) const {
   // decimal part was filled with zeros (this will also deal with the
   // scenario that the decimal part was empty, correctly removing the
   // decimal point):
-  const str_size_type decimal_position = data.whole_string_normalized.find('.');
+  const str_size_type decimal_position = data.whole_string_normalized.find(symbols_.point);
   if ( decimal_position != string::npos ) {
     data.is_integer_literal = false;
     for (auto i = data.whole_string_normalized.length()-1;
          i >= decimal_position; --i) {
-      if ( data.whole_string_normalized.at(i) == digits_.begin()->name() )
+      if ( data.whole_string_normalized[i] == digits_.begin()->name() )
         data.whole_string_normalized.erase(i);
       else
         break;
@@ -422,33 +819,29 @@ Basic_Data<T> Basic_Format<T,U>::compare(const string& str) const {
   //       whole_string: [+-][specifier]
   //       whole_string_normalized: [-][specifier]
   //       ACTION: whole_string_normalized turned to: [-][specifier]0
-  if (data.whole_string ==
-       ((data.is_positive ?
-            (data.is_explicit_positive ? string(1,char_type('+')) : string()) :
-            string(1,char_type('-')))
-        + specifier_) ) {
+  if ( raw_is(data.whole_string, sign, char_type(0)) ) {
     if (data.exponent_position == string::npos)
-      return {};
+      return raw_fail(data, errc::no_digits, str_index);
     else
       data.whole_string_normalized += (digits_.begin()+1)->name();
   }
   //   [+-][specifier]0000...
   //       whole_string: [+-][specifier]
   //       whole_string_normalized: [-][specifier]
-  if (data.whole_string_normalized ==
-       ((data.is_positive ? string() : string(1,char_type('-')))
-        + specifier_) )
+  if ( raw_is(data.whole_string_normalized,
+              data.is_positive ? char_type(0) : symbols_.minus,
+              char_type(0)) )
     data.whole_string_normalized += digits_.begin()->name();
 
   // finally, we finish with the whole string by setting is_zero and finally
   // dealing with the case "-[specifier]0"
-  if (data.whole_string_normalized == (specifier_ + digits_.begin()->name()))
+  if ( raw_is(data.whole_string_normalized, char_type(0),
+              digits_.begin()->name()) )
     data.is_zero = true;
-  else if (data.whole_string_normalized ==
-            (string(1,char_type('-')) + specifier_
-             + digits_.begin()->name()) ) {
+  else if ( raw_is(data.whole_string_normalized, symbols_.minus,
+                   digits_.begin()->name()) ) {
     data.is_zero = true;
-    data.whole_string_normalized = (specifier_ + digits_.begin()->name());
+    data.whole_string_normalized.erase(0, 1);
   }
 
 
@@ -457,75 +850,88 @@ Basic_Data<T> Basic_Format<T,U>::compare(const string& str) const {
     str_index += exp_.length();
     const str_size_type exp_start = str_index;
     // if the exponent is empty, then exit not a number:
-    if ( str.substr(str_index).empty() )
-      return {};
+    if ( str_index >= str_length )
+      return raw_fail(data, errc::no_exponent_digits, str_length);
 
     // look for an exponent pre-digit (+ or - sign)
-    if (str.at(str_index) == char_type('+')) {
+    if (str[str_index] == symbols_.plus) {
       data.is_exponent_explicit_positive = true;
       ++str_index;
     }
-    else if (str.at(str_index) == char_type('-')) {
+    else if (str[str_index] == symbols_.minus) {
       data.is_exponent_positive = false;
-      data.exponent_string_normalized += str.at(str_index);
+      data.exponent_string_normalized += str[str_index];
       ++str_index;
     }
 
     // if the exponent (after a pre-digit) is empty, then exit not a number:
-    if ( str.substr(str_index).empty() )
-      return {};
+    if ( str_index >= str_length )
+      return raw_fail(data, errc::no_exponent_digits, str_length);
 
-    // examine all the digits in the exponent for conformity:
+    // examine all the digits in the exponent for conformity (keeping its
+    // value, if it is limited, for as long as it is within the limit):
     start = true;
-    Count exp_digit_count{ exp_digits_.size() };
+    Count& exp_digit_count = context.exp_digit_count_;
+    exp_digit_count.reset(exp_digits_.size());
+    const unsigned long long exp_base = exp_digits_.size();
+    unsigned long long exp_value = 0;
     for (; str_index < str_length; ++str_index) {
       bool found = false;
       for (auto j = exp_digits_.begin(); j != exp_digits_.end(); ++j) {
-        if ( *j == str.at(str_index) ) {
+        if ( *j == str[str_index] ) {
           found = true;
-          if ( exp_digit_count.count_list_.at(j - exp_digits_.begin())
+          if ( exp_digit_count.count_list_[j - exp_digits_.begin()]
                   >= j->count_max() )
-            return {};
+            return raw_fail(data, errc::exponent_digit_count, str_index);
+          if ( limits.exponent != 0 ) {
+            const unsigned long long value = j - exp_digits_.begin();
+            if ( value > limits.exponent ||
+                 exp_value > (limits.exponent - value) / exp_base )
+              return raw_fail(data, errc::exponent_limit, str_index);
+            exp_value = exp_value * exp_base + value;
+          }
           if ( j->name() != exp_digits_.begin()->name() || start==false ) {
             start = false;
             data.exponent_string_normalized += j->name();
           }
-          ++exp_digit_count.count_list_.at(j - exp_digits_.begin());
+          ++exp_digit_count.count_list_[j - exp_digits_.begin()];
           break;
         }
       }
       if (!found)
-        return {};
+        return raw_fail(data, errc::exponent_digit, str_index);
     }
-    data.exponent_string = str.substr(exp_start,str_length-exp_start);
+    data.exponent_string.assign(str, exp_start, str_length-exp_start);
   }
 
   // deal with the case that all the exponent digits were zero, so no digits
   // we captured into exponent_string_normalized:
   if ( data.exponent_string_normalized.empty() ||
-       data.exponent_string_normalized == string(1,char_type('-')) )
+       (data.exponent_string_normalized.length() == 1 &&
+        data.exponent_string_normalized[0] == symbols_.minus) )
     data.exponent_string_normalized = exp_digits_.begin()->name();
+  const bool exponent_zero =
+      data.exponent_string_normalized.length() == 1 &&
+      data.exponent_string_normalized[0] == exp_digits_.begin()->name();
 
   data.normalized = data.whole_string_normalized;
-  if ( (data.exponent_position != string::npos &&
-        data.exponent_string_normalized !=
-                          string(1, exp_digits_.begin()->name()))
-       && !data.is_zero )
-    data.normalized += exp_ + data.exponent_string_normalized;
+  if ( data.exponent_position != string::npos && !exponent_zero &&
+       !data.is_zero )
+    data.normalized.append(exp_).append(data.exponent_string_normalized);
 
   // finally, we need to determine if the number is an integer or not;
   // first, we'll calculate the whole width (zero if the number is zero, so
   // skip the code if data.is_zero == true)...
   const str_size_type norm_whole_string_decimal_pos =
-      data.whole_string_normalized.find(string(1,char_type('.')));
+      data.whole_string_normalized.find(symbols_.point);
   if ( norm_whole_string_decimal_pos != string::npos )
     data.has_decimal = true; // might as well set this here as were at it
   if ( !data.is_zero ) {
     const str_size_type norm_whole_string_length = 
       data.whole_string_normalized.length();
     if ( norm_whole_string_decimal_pos == string::npos )
-      while (data.whole_string_normalized.at(norm_whole_string_length -
-              data.whole_width-1) == digits_.begin()->name() )
+      while (data.whole_string_normalized[norm_whole_string_length -
+              data.whole_width-1] == digits_.begin()->name() )
         ++data.whole_width;
     else
       data.whole_width = norm_whole_string_decimal_pos -
@@ -537,16 +943,17 @@ Basic_Data<T> Basic_Format<T,U>::compare(const string& str) const {
   if (!data.is_exponent_positive) {
     // only if the normalized exponent is not zero shall we set
     // is_fraction_by_exponent:
-    if ( data.exponent_string_normalized !=
-                                  string(1, exp_digits_.begin()->name()) )
+    if ( !exponent_zero )
       data.is_fraction_by_exponent = true;
     data.exponent_width *= -1;
   }
 
-  // use the whole and exponent widths to set is_integer:
+  // use the whole and exponent widths to set is_integer (the whole width
+  // is at most the length of the string, so it is the one negated, and
+  // the exponent width may be as large as a width_type):
   if ( data.is_zero )
     data.is_integer = true;
-  else if (data.whole_width + data.exponent_width < 0)
+  else if (data.exponent_width < -data.whole_width)
     data.is_integer = false;
   else
     data.is_integer = true;
@@ -563,14 +970,14 @@ Basic_Data<T> Basic_Format<T,U>::compare(const string& str) const {
       const str_size_type start = specifier_.length()
                                       + (data.is_positive ? 0 : 1);
       const str_size_type decimal_pos =
-                  data.whole_string_normalized.find(string(1,char_type('.')));
+                  data.whole_string_normalized.find(symbols_.point);
       if ( decimal_pos == start + 1 ) {
         // we only have one digit before the decimal point.
-        if (data.whole_string_normalized.at(start) == digits_.begin()->name()) {
+        if (data.whole_string_normalized[start] == digits_.begin()->name()) {
           // the digit before the decimal point is zero. We need to find the
           // first non-zero digit after the decimal point:
           str_size_type zeros = 0;
-          while ( data.whole_string_normalized.at(decimal_pos+1+zeros)
+          while ( data.whole_string_normalized[decimal_pos+1+zeros]
                     == digits_.begin()->name() )
             ++zeros;
           data.mantissa = -1*data.whole_width - zeros;
@@ -591,7 +998,29 @@ Basic_Data<T> Basic_Format<T,U>::compare(const string& str) const {
   }
   
   data.is_number = true;
-  return data;
+  return Status{ errc::ok, str_length };
+}
+
+// raw_fail: reset data (so that it records not a number) and return the
+// error
+template <typename T, typename U>
+Status Basic_Format<T,U>::raw_fail(Basic_Data<T>& data, const errc error,
+                                   const str_size_type position) const
+    noexcept {
+  data.clear();
+  return Status{ error, position };
+}
+
+template <typename T, typename U>
+bool Basic_Format<T,U>::raw_is(const string& str, const char_type sign,
+                               const char_type last) const noexcept {
+  const str_size_type start = sign != char_type(0) ? 1 : 0;
+  const str_size_type length = start + specifier_.length()
+                               + (last != char_type(0) ? 1 : 0);
+  return str.length() == length &&
+         (sign == char_type(0) || str[0] == sign) &&
+         str.compare(start, specifier_.length(), specifier_) == 0 &&
+         (last == char_type(0) || str[length - 1] == last);
 }
 
 
@@ -599,146 +1028,3714 @@ Basic_Data<T> Basic_Format<T,U>::compare(const string& str) const {
 
 template <typename T, typename U>
 auto Basic_Format<T,U>::to (const Basic_Format<T,U>& dest,
-                            const string& input) const -> string {
-  const Basic_Data<T> d = compare(input);
-  return (d.is_number && d.is_integer_literal) ? to(dest, d) : string{};
+                            const string& input,
+                            const unsigned threads) const -> string {
+  return to<T,U>(dest, input, threads);
 }
 
 template <typename T, typename U>
 auto Basic_Format<T,U>::to (const Basic_Format<T,U>& dest,
-                            const Basic_Data<T>& data) const -> string {
-  // [-][specifier][whole][.{decimal}][e[-]{exponent}]
-  //
-  const Split s = raw_split(data);
-  const string whole_converted = raw_convert(dest, s.whole_part);
-  const string exponent_converted = s.exponent ?
-                               raw_convert(dest, s.exponent_part, false) :
-                               string{};
-  
-  return (s.whole_positive ? string() : string(1,char_type('-')))
-         + dest.specifier()
-         + whole_converted
-         + (s.exponent ?  dest.exponent_specifier()
-                          + (s.exponent_positive ?
-                             string() : string(1,char_type('-')))
-                          + exponent_converted
-                       : string());
+                            const Basic_Data<T>& data,
+                            const unsigned threads) const -> string {
+  return to<T,U>(dest, data, threads);
 }
 
+template <typename T, typename U>
+template <typename V, typename W>
+std::basic_string<V>
+Basic_Format<T,U>::to (const Basic_Format<V,W>& dest,
+                       const string& input,
+                       const unsigned threads) const {
+  const Basic_Data<T> d = compare(input);
+  std::basic_string<V> output;
+  if (d.is_number && d.is_integer_literal)
+    to(dest, d, output, threads);
+  return output;
+}
 
+template <typename T, typename U>
+template <typename V, typename W>
+std::basic_string<V>
+Basic_Format<T,U>::to (const Basic_Format<V,W>& dest,
+                       const Basic_Data<T>& data,
+                       const unsigned threads) const {
+  std::basic_string<V> output;
+  to(dest, data, output, threads);
+  return output;
+}
 
+template <typename T, typename U>
+template <typename V, typename W>
+void Basic_Format<T,U>::to (const Basic_Format<V,W>& dest,
+                            const Basic_Data<T>& data,
+                            std::basic_string<V>& output,
+                            const unsigned threads) const {
+  // [-][specifier][whole][.{decimal}][e[-]{exponent}], split into its
+  // parts, which raw_to writes
+  raw_to(dest, raw_split(data), output, threads);
+}
 
-
+// to_into method:
+//   void to_into(const Basic_Format<V,W>& dest, const string& input,
+//                std::basic_string<V>& output)
+//
+// as to, into an existing string. With a context, the number is parsed
+// into the context's Basic_Data and split into its Split, whose buffers
+// are reused, and written straight into the output.
+template <typename T, typename U>
+template <typename V, typename W>
+void Basic_Format<T,U>::to_into (const Basic_Format<V,W>& dest,
+                                 const string& input,
+                                 std::basic_string<V>& output,
+                                 const unsigned threads) const {
+  Context context;
+  to_into(dest, input, output, context, threads);
+}
 
 template <typename T, typename U>
-auto Basic_Format<T,U>::raw_str_to_int
-    (const string& input, const bool digit_list) const -> width_type {
-  width_type ret = 0;
-  const str_size_type input_length = input.length();
-  const typename digits_type::size_type base =
-                            digit_list ? digits_.size()-1 : exp_digits_.size();
-  for (str_size_type i=0; i<input_length; ++i) {
-    for (typename digits_type::size_type j=0; j<base; ++j) {
-      if ( (digit_list ? digits_ : exp_digits_).at(j) == input.at(i)) {
-        ret += j*pow(base, (input_length-i-1));
-        break;
-      }
-    }
+template <typename V, typename W>
+void Basic_Format<T,U>::to_into (const Basic_Format<V,W>& dest,
+                                 const string& input,
+                                 std::basic_string<V>& output,
+                                 Context& context,
+                                 const unsigned threads) const {
+  output.clear();
+  if (raw_parse(input, context.data_, context) &&
+      context.data_.is_integer_literal) {
+    raw_split(context.data_, context.split_);
+    raw_to(dest, context.split_, output, threads);
   }
-  return ret;
 }
 
-
+template <typename T, typename U>
+template <typename V, typename W>
+void Basic_Format<T,U>::to_into (const Basic_Predefined_Format<V,W>& dest,
+                                 const string& input,
+                                 std::basic_string<V>& output,
+                                 const unsigned threads) const {
+  to_into(dest.get(), input, output, threads);
+}
 
 template <typename T, typename U>
-auto Basic_Format<T,U>::raw_int_to_str
-      (const Basic_Format<T,U>& dest, width_type input,
-       const bool digit_list) const -> string {
-  if (input==0)
-    return string(1, dest.digits().begin()->name());
-  const auto base = digit_list ? dest.digits().size() - 1 :
-                                 dest.exponent_digits().size();
-  if (input < 0 ||
-      static_cast<std::make_unsigned<width_type>::type>(input) < base)
-    return string(1, (digit_list ? dest.digits() : dest.exponent_digits())
-                     .at(input).name());
-
-  string ret;
-  auto power = 0;
-  while ( pow(base, power) <= input )
-    ++power;
-  while (--power, input > 0) {
-    auto digit = 0;
-    while ( digit*pow(base, power) <= input )
-      ++digit;
-    --digit;
-    ret += (digit_list ? dest.digits() : dest.exponent_digits())
-           .at(digit).name();
-    input -= digit*pow(base, power);
-  }
-  for (; power >= 0; --power)
-    ret += (digit_list ? dest.digits() : dest.exponent_digits())
-           .begin()->name();
-  return ret;
+template <typename V, typename W>
+void Basic_Format<T,U>::to_into (const Basic_Predefined_Format<V,W>& dest,
+                                 const string& input,
+                                 std::basic_string<V>& output,
+                                 Context& context,
+                                 const unsigned threads) const {
+  to_into(dest.get(), input, output, context, threads);
 }
 
+// convert: as to, but the reason a string cannot be converted is returned:
+// the error from parse, or errc::not_integer (at the decimal point or the
+// exponent) if it is a number but not an integer literal
+template <typename T, typename U>
+template <typename V, typename W>
+Status Basic_Format<T,U>::convert(const Basic_Format<V,W>& dest,
+                                  const string& input,
+                                  std::basic_string<V>& output,
+                                  const unsigned threads) const noexcept {
+  Basic_Data<T> data;
+  const Status status = parse(input, data);
+  if (!status)
+    return status;
+  if (!data.is_integer_literal)
+    return Status{ errc::not_integer,
+                   std::min(input.find(symbols_.point),
+                            data.exponent_position) };
+  to(dest, data, output, threads);
+  return status;
+}
 
+// convert, with limits: the string is parsed within the limits, and then
+// the cost of its conversion (the squares of the numbers of digits in the
+// normalized whole part and exponent, which are what is converted) is
+// checked before anything is converted
+template <typename T, typename U>
+template <typename V, typename W>
+Status Basic_Format<T,U>::convert(const Basic_Format<V,W>& dest,
+                                  const string& input,
+                                  std::basic_string<V>& output,
+                                  const Limits& limits,
+                                  const unsigned threads) const noexcept {
+  Basic_Data<T> data;
+  Context context;
+  const Status status = raw_parse(input, data, context, limits);
+  if (!status)
+    return status;
+  if (!data.is_integer_literal)
+    return Status{ errc::not_integer,
+                   std::min(input.find(symbols_.point),
+                            data.exponent_position) };
+  if (limits.cost != 0) {
+    // (a square that would overflow is over any limit)
+    auto square = [](const unsigned long long n) {
+      return n > 0xffffffffull ? std::numeric_limits<unsigned long long>::max()
+                               : n * n;
+    };
+    const string& w = data.whole_string_normalized;
+    const string& e = data.exponent_string_normalized;
+    const unsigned long long whole = square(
+        w.length() - specifier_.length() - (w[0] == symbols_.minus ? 1 : 0));
+    const unsigned long long exponent =
+        square(e.length() - (e[0] == symbols_.minus ? 1 : 0));
+    if (whole > limits.cost || exponent > limits.cost - whole)
+      return Status{ errc::cost_limit, 0 };
+  }
+  to(dest, data, output, threads);
+  return status;
+}
 
 template <typename T, typename U>
-auto Basic_Format<T,U>::raw_convert(const Basic_Format<T,U>& dest,
-                                    const string& input,
-                                    const bool digit_list) const -> string {
-  const width_type internal_number
-      = raw_str_to_int(input, digit_list);
-  return raw_int_to_str(dest, internal_number, digit_list);
+template <typename V, typename W>
+std::basic_string<V>
+Basic_Format<T,U>::to (const Basic_Predefined_Format<V,W>& dest,
+                       const string& input,
+                       const unsigned threads) const {
+  return to(dest.get(), input, threads);
 }
 
+template <typename T, typename U>
+template <typename V, typename W>
+std::basic_string<V>
+Basic_Format<T,U>::to (const Basic_Predefined_Format<V,W>& dest,
+                       const Basic_Data<T>& data,
+                       const unsigned threads) const {
+  return to(dest.get(), data, threads);
+}
 
+// to_places method:
+//   std::basic_string<V> to_places(const Basic_Format<V,W>& dest,
+//                                  const string& input,
+//                                  const std::size_t places,
+//                                  const Rounding mode)
+//
+// as to, but for any number, not only integer literals: the fraction is
+// converted too (see raw_to_places)
+template <typename T, typename U>
+template <typename V, typename W>
+std::basic_string<V>
+Basic_Format<T,U>::to_places (const Basic_Format<V,W>& dest,
+                              const string& input,
+                              const std::size_t places,
+                              const Rounding mode,
+                              const unsigned threads) const {
+  return to_places(dest, compare(input), places, mode, threads);
+}
 
+template <typename T, typename U>
+template <typename V, typename W>
+std::basic_string<V>
+Basic_Format<T,U>::to_places (const Basic_Format<V,W>& dest,
+                              const Basic_Data<T>& data,
+                              const std::size_t places,
+                              const Rounding mode,
+                              const unsigned threads) const {
+  std::basic_string<V> output;
+  if (!data.is_number)
+    return output;
+  Split s = raw_split(data);
+  if (s.exponent && !data.is_integer_literal &&
+      !raw_fold(s, data.exponent_width, dest.digits().size() - 1, places))
+    return output;
+  raw_to_places(dest, s, output, places, mode, threads);
+  return output;
+}
 
 template <typename T, typename U>
-auto Basic_Format<T,U>::raw_split(const Basic_Data<T>& data) const -> Split {
-  Split s;
-  // [-][specifier][whole][.{decimal}][e[-]{exponent}]
+template <typename V, typename W>
+std::basic_string<V>
+Basic_Format<T,U>::to_places (const Basic_Predefined_Format<V,W>& dest,
+                              const string& input,
+                              const std::size_t places,
+                              const Rounding mode,
+                              const unsigned threads) const {
+  return to_places(dest.get(), input, places, mode, threads);
+}
 
-  str_size_type whole_start = specifier_.length();
-  if (data.normalized.at(0) == char_type('-')) {
-    s.whole_positive = data.is_positive;
-    ++whole_start;
-  }
+template <typename T, typename U>
+template <typename V, typename W>
+std::basic_string<V>
+Basic_Format<T,U>::to_places (const Basic_Predefined_Format<V,W>& dest,
+                              const Basic_Data<T>& data,
+                              const std::size_t places,
+                              const Rounding mode,
+                              const unsigned threads) const {
+  return to_places(dest.get(), data, places, mode, threads);
+}
 
-  const str_size_type exp_pos = data.normalized.find(exp_);
-  if (exp_pos != string::npos) {
-    s.exponent = true;
-    str_size_type exp_start = exp_pos + exp_.length();
-    s.exponent_positive = data.is_exponent_positive;
-    if (!s.exponent_positive)
-      ++exp_start;
-    s.exponent_part = data.normalized.substr(exp_start);
-  }
+// to_batch method:
+//   Basic_Batch<V> to_batch(const Basic_Format<V,W>& dest,
+//                           const std::vector<string>& inputs)
+//
+// as to, for every input, but with one Context (see to_into) reused for
+// all the rows, the digits looked up in tables (built once) rather than
+// searched for, and each row written straight onto the end of the batch's
+// buffer. The offsets and the bitmap are allocated once, up front.
+template <typename T, typename U>
+template <typename V, typename W>
+Basic_Batch<V>
+Basic_Format<T,U>::to_batch (const Basic_Format<V,W>& dest,
+                             const std::vector<string>& inputs,
+                             const unsigned threads) const {
+  Basic_Batch<V> batch;
+  batch.offsets.reserve(inputs.size() + 1);
+  batch.validity.assign((inputs.size() + 7) / 8, 0);
 
-  const str_size_type decimal_pos = data.normalized.find(char_type('.'));
-  if (decimal_pos == string::npos) {
-    if (exp_pos == string::npos)
-      s.whole_part = data.normalized.substr(whole_start);
-    else
-      s.whole_part = data.normalized.substr(whole_start, exp_pos-whole_start);
-  }
-  else {
-    s.decimal = true;
-    if (exp_pos == string::npos) {
-      s.whole_part = data.normalized.substr(whole_start,
-                                            decimal_pos-whole_start);
-      s.decimal_part = data.normalized.substr(decimal_pos+1);
+  const Lookup whole(digits_);
+  const Lookup exponent(exp_digits_);
+  Context context;
+  for (std::size_t row = 0; row < inputs.size(); ++row) {
+    if (raw_parse(inputs[row], context.data_, context) &&
+        context.data_.is_integer_literal) {
+      raw_split(context.data_, context.split_);
+      raw_to(dest, context.split_, batch.buffer, threads, &whole, &exponent);
+      batch.validity[row / 8] |=
+                        static_cast<std::uint8_t>(1u << (row % 8));
     }
     else {
-      s.whole_part = data.normalized.substr(whole_start, exp_pos-whole_start);
-      s.decimal_part = data.normalized.substr(decimal_pos+1,
-                                              exp_pos-decimal_pos-1);
+      ++batch.null_count;
+      if (!inputs[row].empty())
+        batch.rejected.push_back(row);
     }
+    batch.offsets.push_back(batch.buffer.size());
   }
+  return batch;
+}
 
-  return s;
+template <typename T, typename U>
+template <typename V, typename W>
+Basic_Batch<V>
+Basic_Format<T,U>::to_batch (const Basic_Predefined_Format<V,W>& dest,
+                             const std::vector<string>& inputs,
+                             const unsigned threads) const {
+  return to_batch(dest.get(), inputs, threads);
+}
+
+
+
+
+
+
+// order method:
+//   int order(const string& a, const string& b)
+//
+// compare a and b by their numerical value. Neither number is converted to
+// an integer: the digits are compared one by one, so the numbers can be of
+// any length.
+template <typename T, typename U>
+int Basic_Format<T,U>::order(const string& a, const string& b) const {
+  return order(compare(a), compare(b));
+}
+
+template <typename T, typename U>
+int Basic_Format<T,U>::order (const Basic_Data<T>& a,
+                              const Basic_Data<T>& b) const {
+  // strings that are not numbers come before all numbers:
+  if (!a.is_number || !b.is_number)
+    return int(a.is_number) - int(b.is_number);
+
+  Scientific sa, sb;
+  raw_scientific(a, sa);
+  raw_scientific(b, sb);
+  return raw_order(sa, sb);
+}
+
+// sort_key method:
+//   std::string sort_key(const string& input)
+//
+// The key is made up of:
+//   (i)   one byte for the sign of the number: 1 for negative numbers, 2
+//         for zero and 3 for positive numbers (zero has no other bytes);
+//   (ii)  the power of base of the number (see struct Scientific), in 9
+//         bytes, most significant first, offset by 2^64 so that negative
+//         powers come before positive ones (the power can be a little
+//         beyond a width_type, so it takes more than 8 bytes);
+//   (iii) the value of each digit (see struct Scientific) plus one, in 1
+//         byte (or 2 or 4 bytes, most significant first, if the format has
+//         more than 254 or 65534 digits);
+//   (iv)  a terminating zero value, in the same number of bytes.
+// The bytes after (i) are inverted for negative numbers, so that larger
+// magnitudes come first.
+template <typename T, typename U>
+std::string Basic_Format<T,U>::sort_key(const string& input) const {
+  return sort_key(compare(input));
+}
+
+template <typename T, typename U>
+std::string Basic_Format<T,U>::sort_key(const Basic_Data<T>& data) const {
+  std::string key;
+  if (!data.is_number)
+    return key;
+
+  Scientific sci;
+  raw_scientific(data, sci);
+  if (sci.zero) {
+    key += char(2);
+    return key;
+  }
+  key += char(sci.positive ? 3 : 1);
+
+  // the scale offset by 2^63, then the exponent added with a carry (or
+  // borrow) into the ninth byte
+  const unsigned long long scale =
+          static_cast<unsigned long long>(sci.scale) ^ (1ULL << 63);
+  const unsigned long long power =
+          scale + static_cast<unsigned long long>(sci.exponent);
+  int high = 1;
+  if (sci.exponent > 0 && power < scale)
+    ++high;
+  else if (sci.exponent < 0 && power > scale)
+    --high;
+  key += char(high);
+  for (int i = 7; i >= 0; --i)
+    key += char((power >> (8*i)) & 0xff);
+
+  const std::size_t base = digits_.size()-1;
+  const int width = base < 0xff ? 1 : (base < 0xffff ? 2 : 4);
+  key.reserve(key.size() + (sci.digits.size()+1)*width);
+  for (std::size_t i = 0; i <= sci.digits.size(); ++i) {
+    const unsigned long value =
+                        i < sci.digits.size() ? sci.digits[i] + 1 : 0;
+    for (int j = width-1; j >= 0; --j)
+      key += char((value >> (8*j)) & 0xff);
+  }
+
+  if (!sci.positive)
+    for (auto i = key.begin()+1; i != key.end(); ++i)
+      *i = char(~*i);
+  return key;
+}
+
+
+
+
+
+
+// value method:
+//   Numeric_Value value(const string& input)
+//
+// the scientific form of the number (see raw_scientific) with the base of
+// the format attached.
+template <typename T, typename U>
+Numeric_Value Basic_Format<T,U>::value(const string& input) const {
+  return value(compare(input));
+}
+
+template <typename T, typename U>
+Numeric_Value Basic_Format<T,U>::value(const Basic_Data<T>& data) const {
+  Numeric_Value v;
+  if (!data.is_number)
+    return v;
+  Scientific sci;
+  raw_scientific(data, sci);
+  v.is_number = true;
+  v.is_zero = sci.zero;
+  v.is_positive = sci.positive;
+  v.base = digits_.size()-1;
+  v.exponent = sci.exponent;
+  v.scale = sci.scale;
+  v.digits = std::move(sci.digits);
+  return v;
+}
+
+template <typename T, typename U>
+std::size_t Basic_Format<T,U>::hash(const string& input) const {
+  return value(input).hash();
+}
+
+template <typename T, typename U>
+std::size_t Basic_Format<T,U>::hash(const Basic_Data<T>& data) const {
+  return value(data).hash();
+}
+
+
+template <typename T, typename U>
+auto Basic_Format<T,U>::round(const string& input, const std::size_t digits,
+                              const Rounding mode) const -> string {
+  return round(compare(input), digits, mode);
+}
+
+// round: keep the first `digits' significant digits of the scientific form
+template <typename T, typename U>
+auto Basic_Format<T,U>::round(const Basic_Data<T>& data,
+                              const std::size_t digits,
+                              const Rounding mode) const -> string {
+  if (!data.is_number)
+    return string();
+  Scientific sci;
+  raw_scientific(data, sci);
+  const std::size_t keep = std::min<std::size_t>(
+        std::max<std::size_t>(digits, 1),
+        static_cast<std::size_t>(std::numeric_limits<width_type>::max()));
+  if (!raw_round(sci, static_cast<width_type>(keep), mode))
+    return string();
+  return raw_format(sci);
+}
+
+template <typename T, typename U>
+auto Basic_Format<T,U>::round_places(const string& input,
+                                     const width_type places,
+                                     const Rounding mode) const -> string {
+  return round_places(compare(input), places, mode);
+}
+
+// round_places: the digit at position i of the scientific form (counting
+// from 1) has the weight base^(exponent+scale-i), so the digits kept are
+// those up to position exponent+scale+places. A position above a
+// width_type keeps every digit; one below it keeps none, and a unit in the
+// last place kept (base^(1-scale-places) over base^scale) is then too
+// large to write.
+template <typename T, typename U>
+auto Basic_Format<T,U>::round_places(const Basic_Data<T>& data,
+                                     const width_type places,
+                                     const Rounding mode) const -> string {
+  if (!data.is_number)
+    return string();
+  Scientific sci;
+  raw_scientific(data, sci);
+  if (sci.zero)
+    return raw_format(sci);
+
+  width_type shift, keep;
+  const bool fits = raw_checked_add(sci.scale, places, shift);
+  if (fits && raw_checked_add(sci.exponent, shift, keep)) {
+    if (!raw_round(sci, keep, mode))
+      return string();
+  }
+  else if (fits ? shift < 0 : places < 0) {
+    if (raw_round_up(mode, -1, sci.positive, false))
+      return string();
+    sci.zero = true;
+    sci.positive = true;
+    sci.exponent = 0;
+    sci.digits.clear();
+  }
+  return raw_format(sci);
+}
+
+template <typename T, typename U>
+auto Basic_Format<T,U>::truncate(const string& input) const -> string {
+  return truncate(compare(input));
+}
+
+template <typename T, typename U>
+auto Basic_Format<T,U>::truncate(const Basic_Data<T>& data) const -> string {
+  return round_places(data, 0, Rounding::toward_zero);
+}
+
+
+
+// add, subtract, multiply and negate methods:
+//   string add(const string& a, const string& b)
+//
+// the operands are parsed, put in scientific form and worked on there (see
+// raw_add and raw_multiply); the result is written with the exponent of
+// the operation (see raw_arithmetic)
+template <typename T, typename U>
+auto Basic_Format<T,U>::add(const string& a, const string& b) const
+    -> string {
+  return add(compare(a), compare(b));
+}
+
+template <typename T, typename U>
+auto Basic_Format<T,U>::add(const Basic_Data<T>& a,
+                            const Basic_Data<T>& b) const -> string {
+  string output;
+  Context context;
+  raw_arithmetic(Operation::add, a, b, output, context);
+  return output;
+}
+
+template <typename T, typename U>
+auto Basic_Format<T,U>::subtract(const string& a, const string& b) const
+    -> string {
+  return subtract(compare(a), compare(b));
+}
+
+template <typename T, typename U>
+auto Basic_Format<T,U>::subtract(const Basic_Data<T>& a,
+                                 const Basic_Data<T>& b) const -> string {
+  string output;
+  Context context;
+  raw_arithmetic(Operation::subtract, a, b, output, context);
+  return output;
+}
+
+template <typename T, typename U>
+auto Basic_Format<T,U>::multiply(const string& a, const string& b) const
+    -> string {
+  return multiply(compare(a), compare(b));
+}
+
+template <typename T, typename U>
+auto Basic_Format<T,U>::multiply(const Basic_Data<T>& a,
+                                 const Basic_Data<T>& b) const -> string {
+  string output;
+  Context context;
+  raw_arithmetic(Operation::multiply, a, b, output, context);
+  return output;
+}
+
+template <typename T, typename U>
+auto Basic_Format<T,U>::negate(const string& a) const -> string {
+  return negate(compare(a));
+}
+
+template <typename T, typename U>
+auto Basic_Format<T,U>::negate(const Basic_Data<T>& a) const -> string {
+  string output;
+  Context context;
+  raw_arithmetic(Operation::negate, a, a, output, context);
+  return output;
+}
+
+template <typename T, typename U>
+int Basic_Format<T,U>::sign(const string& a) const {
+  return sign(compare(a));
+}
+
+template <typename T, typename U>
+int Basic_Format<T,U>::sign(const Basic_Data<T>& a) const {
+  if (!a.is_number || a.is_zero)
+    return 0;
+  return a.is_positive ? 1 : -1;
+}
+
+// add_into, subtract_into, multiply_into and negate_into methods:
+//   void add_into(const string& a, const string& b, string& output,
+//                 Context& context)
+//
+// as add, etc., with the operands parsed into the context (so the output
+// may be one of them: it is not touched until they have been read)
+template <typename T, typename U>
+void Basic_Format<T,U>::add_into(const string& a, const string& b,
+                                 string& output, Context& context) const {
+  raw_parse(a, context.data_, context);
+  raw_parse(b, context.other_, context);
+  raw_arithmetic(Operation::add, context.data_, context.other_, output,
+                 context);
+}
+
+template <typename T, typename U>
+void Basic_Format<T,U>::subtract_into(const string& a, const string& b,
+                                      string& output,
+                                      Context& context) const {
+  raw_parse(a, context.data_, context);
+  raw_parse(b, context.other_, context);
+  raw_arithmetic(Operation::subtract, context.data_, context.other_, output,
+                 context);
+}
+
+template <typename T, typename U>
+void Basic_Format<T,U>::multiply_into(const string& a, const string& b,
+                                      string& output,
+                                      Context& context) const {
+  raw_parse(a, context.data_, context);
+  raw_parse(b, context.other_, context);
+  raw_arithmetic(Operation::multiply, context.data_, context.other_, output,
+                 context);
+}
+
+template <typename T, typename U>
+void Basic_Format<T,U>::negate_into(const string& a, string& output,
+                                    Context& context) const {
+  raw_parse(a, context.data_, context);
+  raw_arithmetic(Operation::negate, context.data_, context.data_, output,
+                 context);
+}
+
+
+
+// pattern method:
+//   string pattern(const Syntax syntax)
+//
+// the grammar of raw_parse, written out as
+//   ^[sign]{specifier}({whole}({exponent})?|{exponent})$
+// where the whole part is an integer part (with its separators in groups,
+// if the format has them) and an optional fraction, or a fraction alone:
+// a lone point, or nothing but a sign and the specifier, is not a number.
+// An exponent string of one character cannot be part of the whole part
+// (it is read as the exponent wherever it appears), so it is left out of
+// the whole part's characters. In a POSIX bracket expression nothing is
+// escaped, so `]' goes first, and `-' last; the characters are listed one
+// by one (a range depends on the locale). In ECMAScript, ranges of three
+// or more characters are written as ranges.
+template <typename T, typename U>
+auto Basic_Format<T,U>::pattern(const Syntax syntax) const -> string {
+  typedef typename std::make_unsigned<char_type>::type unsigned_type;
+  const bool posix = syntax == Syntax::posix;
+  const char* const special = posix ? ".[\\()*+?{|^$" : ".[\\()*+?{|^$]}";
+  auto is_ascii = [](const char_type c, const char* list) {
+    const unsigned_type u = static_cast<unsigned_type>(c);
+    return u != 0 && u < 128 && std::strchr(list, static_cast<char>(u));
+  };
+
+  string out;
+  auto put = [&out](const char* s) {
+    for (; *s; ++s)
+      out += static_cast<char_type>(*s);
+  };
+  auto literal = [&](const char_type c) {
+    if (is_ascii(c, special))
+      out += char_type('\\');
+    out += c;
+  };
+  auto bracket = [&](std::vector<char_type> chars) {
+    chars.erase(std::unique(chars.begin(), chars.end()), chars.end());
+    if (chars.size() == 1) {
+      literal(chars[0]);
+      return;
+    }
+    out += char_type('[');
+    if (posix) {
+      const char_type close(']'), hat('^'), dash('-');
+      const bool has_close = std::count(chars.begin(), chars.end(), close);
+      const bool has_hat = std::count(chars.begin(), chars.end(), hat);
+      const bool has_dash = std::count(chars.begin(), chars.end(), dash);
+      if (has_close)
+        out += close;
+      for (auto c : chars)
+        if (c != close && c != hat && c != dash)
+          out += c;
+      // a `^' first would negate the expression, so if it is all that is
+      // left bar a `-', the `-' goes first instead
+      if (has_hat && out.back() == char_type('[')) {
+        out += dash;
+        out += hat;
+      }
+      else {
+        if (has_hat)
+          out += hat;
+        if (has_dash)
+          out += dash;
+      }
+    }
+    else {
+      std::sort(chars.begin(), chars.end(),
+                [](const char_type a, const char_type b) {
+                  return static_cast<unsigned_type>(a) <
+                         static_cast<unsigned_type>(b);
+                });
+      auto member = [&](const char_type c) {
+        if (is_ascii(c, "\\]^-["))
+          out += char_type('\\');
+        out += c;
+      };
+      for (std::size_t i = 0; i < chars.size(); ) {
+        std::size_t j = i;
+        while (j + 1 < chars.size() &&
+               static_cast<unsigned_type>(chars[j + 1]) ==
+                   static_cast<unsigned_type>(chars[j]) + 1)
+          ++j;
+        member(chars[i]);
+        if (j >= i + 2) {
+          out += char_type('-');
+          member(chars[j]);
+        }
+        else if (j == i + 1)
+          member(chars[j]);
+        i = j + 1;
+      }
+    }
+    out += char_type(']');
+  };
+  auto number = [&](const std::size_t n) {
+    const std::string s = std::to_string(n);
+    put(s.c_str());
+  };
+
+  // the whole part's digits (the point and separator apart), and the
+  // exponent's
+  const std::vector<char_type> whole = raw_whole_characters();
+  std::vector<char_type> digits;
+  bool point = false, separator = false;
+  for (auto c : whole) {
+    if (c == symbols_.point)
+      point = true;
+    else if (symbols_.separator != char_type(0) && c == symbols_.separator)
+      separator = true;
+    else
+      digits.push_back(c);
+  }
+  std::vector<char_type> exp_digits;
+  for (auto i = exp_digits_.begin(); i != exp_digits_.end(); ++i)
+    exp_digits.push_back(i->name());
+  const std::vector<char_type> signs{ symbols_.plus, symbols_.minus };
+
+  put("^");
+  bracket(signs);
+  if ( specifier_.empty() ||
+       (specifier_[0] != symbols_.plus && specifier_[0] != symbols_.minus) )
+    put("?");
+  for (auto c : specifier_)
+    literal(c);
+
+  // ...the exponent, [+-]?{exponent digits}+, after its string
+  auto exponent = [&]() {
+    for (auto c : exp_)
+      literal(c);
+    bracket(signs);
+    put("?");
+    bracket(exp_digits);
+    put("+");
+  };
+  if (exp_.empty()) {
+    // the exponent starts straight after the specifier
+    exponent();
+    put("$");
+    return out;
+  }
+
+  put("((");
+  // the integer part: digits, or digits in groups
+  if (!separator) {
+    bracket(digits);
+    put("+");
+  }
+  else if (symbols_.group == 0) {
+    bracket(digits);
+    put("+(");
+    literal(symbols_.separator);
+    bracket(digits);
+    put("+)*");
+  }
+  else {
+    put("(");
+    bracket(digits);
+    put("+|");
+    bracket(digits);
+    put("{1,");
+    number(symbols_.group);
+    put("}(");
+    literal(symbols_.separator);
+    bracket(digits);
+    put("{");
+    number(symbols_.group);
+    put("})+)");
+  }
+  // ...then a fraction, or a fraction alone
+  if (point) {
+    put("(");
+    literal(symbols_.point);
+    bracket(digits);
+    put("*)?|");
+    literal(symbols_.point);
+    bracket(digits);
+    put("+");
+  }
+  put(")(");
+  exponent();
+  put(")?|");
+  exponent();
+  put(")$");
+  return out;
+}
+
+// pattern_exact: see pattern, and raw_parse, which reads a sign first
+// whatever follows it
+template <typename T, typename U>
+bool Basic_Format<T,U>::pattern_exact() const {
+  if (raw_counted())
+    return false;
+  if ( exp_.length() > 1 ) {
+    const std::vector<char_type> whole = raw_whole_characters();
+    if (std::find(whole.begin(), whole.end(), exp_[0]) != whole.end())
+      return false;
+  }
+  if ( specifier_.empty() ) {
+    auto sign = [this](const char_type c) {
+      return c == symbols_.plus || c == symbols_.minus;
+    };
+    if ( (!exp_.empty() && sign(exp_[0])) || sign(symbols_.point) )
+      return false;
+  }
+  return true;
+}
+
+// automaton method:
+//   Byte_Automaton automaton()
+//
+// the states are those of raw_parse as it reads a string a character at a
+// time (see struct Reading, below), found from the start state by trying
+// every byte in each new state. raw_parse looks for the exponent string
+// ahead of each character of the whole part, which an automaton cannot do:
+// instead, the characters that could be the start of the exponent string
+// are held back (as many as match it so far) until it is either complete
+// or cannot be, when the first of them is read as part of the whole part
+// and the rest looked at again. The bytes that lead every state to the
+// same state are then put in a class.
+template <typename T, typename U>
+Byte_Automaton Basic_Format<T,U>::automaton() const {
+  typedef typename std::make_unsigned<char_type>::type unsigned_type;
+  Byte_Automaton a;
+  {
+    // a character of 256 or over cannot be read as a byte
+    std::vector<char_type> chars(specifier_.begin(), specifier_.end());
+    chars.insert(chars.end(), exp_.begin(), exp_.end());
+    for (auto i = digits_.begin(); i != digits_.end(); ++i)
+      chars.push_back(i->name());
+    for (auto i = exp_digits_.begin(); i != exp_digits_.end(); ++i)
+      chars.push_back(i->name());
+    chars.push_back(symbols_.plus);
+    chars.push_back(symbols_.minus);
+    chars.push_back(symbols_.separator);
+    for (auto c : chars)
+      if (static_cast<unsigned_type>(c) > 0xff)
+        return a;
+  }
+
+  // the state of a reading: its phase, the specifier characters read (in
+  // the specifier) or exponent string characters held back (in the whole
+  // part), and the whole part so far: its digit groups (see Groups), its
+  // point and whether it is empty, a lone point or more
+  enum Phase { start, specifier, whole, exponent, exponent_sign,
+               exponent_digits, dead };
+  enum Read { nothing, lone_point, more };
+  struct Reading {
+    Phase        phase;
+    std::size_t  index;
+    bool         separated;
+    std::size_t  count;
+    bool         point;
+    Read         read;
+  };
+  const std::size_t width = symbols_.group;
+
+  auto groups_end = [width](const Reading& r) {
+    return !r.separated || (r.count != 0 && (width == 0 || r.count == width));
+  };
+  // read a character of the whole part, returning false if it cannot be
+  auto whole_char = [&](Reading& r, const char_type c) {
+    if ( symbols_.separator != char_type(0) && c == symbols_.separator ) {
+      if ( r.point || r.count == 0 ||
+           (r.separated ? width != 0 && r.count != width
+                        : width != 0 && r.count > width) )
+        return false;
+      r.separated = true;
+      r.count = 0;
+      r.read = more;
+      return true;
+    }
+    auto j = digits_.begin();
+    while (j != digits_.end() && *j != c)
+      ++j;
+    if (j == digits_.end())
+      return false;
+    if ( j->name() == symbols_.point ) {
+      // (a point may be used once)
+      if ( r.point || !groups_end(r) )
+        return false;
+      r.point = true;
+      r.read = r.read == nothing ? lone_point : more;
+      return true;
+    }
+    if ( !r.point )
+      r.count = std::min(r.count + 1, width + 1);
+    r.read = more;
+    return true;
+  };
+  // can the whole part end here (before an exponent, if the bool is true)
+  auto whole_end = [&](const Reading& r, const bool exp) {
+    return (r.point || groups_end(r)) && r.read != lone_point &&
+           (exp || r.read != nothing);
+  };
+  auto is_exp_digit = [this](const char_type c) {
+    for (auto j = exp_digits_.begin(); j != exp_digits_.end(); ++j)
+      if (*j == c)
+        return true;
+    return false;
+  };
+  // move on from the specifier once it has all been read
+  auto settle = [&](Reading& r) {
+    if (r.phase == specifier && r.index == specifier_.length()) {
+      r.phase = exp_.empty() ? exponent : whole;
+      r.index = 0;
+    }
+  };
+  // read a character, returning false if the reading is dead
+  std::function<bool(Reading&, const char_type)> step =
+      [&](Reading& r, const char_type c) -> bool {
+    switch (r.phase) {
+    case start:
+      r.phase = specifier;
+      r.index = 0;
+      settle(r);
+      if (c == symbols_.plus || c == symbols_.minus)
+        return true;
+      return step(r, c);
+    case specifier:
+      if (c != specifier_[r.index])
+        return false;
+      ++r.index;
+      settle(r);
+      return true;
+    case whole: {
+      string held(exp_, 0, r.index);
+      held += c;
+      for (;;) {
+        if (held == exp_) {
+          if (!whole_end(r, true))
+            return false;
+          r.phase = exponent;
+          r.index = 0;
+          return true;
+        }
+        if (exp_.compare(0, held.length(), held) == 0) {
+          r.index = held.length();
+          return true;
+        }
+        if (!whole_char(r, held[0]))
+          return false;
+        held.erase(0, 1);
+        if (held.empty()) {
+          r.index = 0;
+          return true;
+        }
+      }
+    }
+    case exponent:
+      if (c == symbols_.plus || c == symbols_.minus) {
+        r.phase = exponent_sign;
+        return true;
+      }
+      // fall through
+    case exponent_sign:
+    case exponent_digits:
+      r.phase = exponent_digits;
+      return is_exp_digit(c);
+    case dead:
+      break;
+    }
+    return false;
+  };
+  auto accepting = [&](Reading r) {
+    if (r.phase == exponent_digits)
+      return true;
+    if (r.phase != whole)
+      return false;
+    for (std::size_t i = 0; i < r.index; ++i)
+      if (!whole_char(r, exp_[i]))
+        return false;
+    return whole_end(r, false);
+  };
+
+  // find the states, and the next state for each byte
+  std::vector<Reading> states;
+  std::map<std::vector<std::size_t>, std::uint32_t> numbers;
+  auto number = [&](const Reading& r) {
+    const std::vector<std::size_t> key{
+        static_cast<std::size_t>(r.phase), r.index, r.separated, r.count,
+        r.point, static_cast<std::size_t>(r.read) };
+    auto i = numbers.find(key);
+    if (i != numbers.end())
+      return i->second;
+    const std::uint32_t n = static_cast<std::uint32_t>(states.size());
+    numbers.emplace(key, n);
+    states.push_back(r);
+    return n;
+  };
+  number(Reading{ start, 0, false, 0, false, nothing });
+  a.dead = number(Reading{ dead, 0, false, 0, false, nothing });
+  std::vector<std::uint32_t> next;
+  for (std::size_t s = 0; s < states.size(); ++s)
+    for (unsigned b = 0; b < 256; ++b) {
+      Reading r = states[s];
+      next.push_back(step(r, static_cast<char_type>(b)) ? number(r)
+                                                        : a.dead);
+    }
+
+  // the classes: the bytes with the same next states
+  std::map<std::vector<std::uint32_t>, std::uint8_t> classes;
+  std::vector<std::uint32_t> column(states.size());
+  a.classes.resize(256);
+  for (unsigned b = 0; b < 256; ++b) {
+    for (std::size_t s = 0; s < states.size(); ++s)
+      column[s] = next[s * 256 + b];
+    auto i = classes.emplace(column,
+                             static_cast<std::uint8_t>(classes.size())).first;
+    a.classes[b] = i->second;
+  }
+  a.class_count = static_cast<std::uint32_t>(classes.size());
+  a.transitions.resize(states.size() * a.class_count);
+  for (std::size_t s = 0; s < states.size(); ++s)
+    for (unsigned b = 0; b < 256; ++b)
+      a.transitions[s * a.class_count + a.classes[b]] = next[s * 256 + b];
+  for (std::size_t s = 0; s < states.size(); ++s)
+    a.accepting.push_back(accepting(states[s]) ? 1 : 0);
+  a.exact = !raw_counted();
+  return a;
+}
+
+
+
+
+
+
+// decode method:
+//   Column<V> decode(const char_type* first, const char_type* last,
+//                    char_type delimiter)
+//
+// the rows are counted first (a quick scan for the delimiter) so that the
+// buffers are allocated once; each row is then decoded straight from the
+// text by raw_decode.
+template <typename T, typename U>
+template <typename V>
+Column<V> Basic_Format<T,U>::decode(const string& text,
+                                    const char_type delimiter) const {
+  return decode<V>(text.data(), text.data() + text.length(), delimiter);
+}
+
+template <typename T, typename U>
+template <typename V>
+Column<V> Basic_Format<T,U>::decode(const char_type* const text,
+                                    const char_type* const end,
+                                    const char_type delimiter) const {
+  Column<V> column;
+  std::size_t rows = std::count(text, end, delimiter);
+  if (text != end && end[-1] != delimiter)
+    ++rows;
+  column.values.reserve(rows);
+  column.validity.assign((rows + 7) / 8, 0);
+
+  Lookup whole(digits_);
+  Lookup exponent(exp_digits_);
+  std::size_t row = 0;
+  for (const char_type* first = text; first != end; ++row) {
+    const char_type* last = std::find(first, end, delimiter);
+    const char_type* const next = last == end ? end : last + 1;
+    if (delimiter == char_type('\n') && last != first &&
+        last[-1] == char_type('\r'))
+      --last;
+
+    V value = V();
+    if (first == last)
+      ++column.null_count;
+    else if (raw_decode(first, last, whole, exponent, value))
+      column.validity[row / 8] |= static_cast<std::uint8_t>(1u << (row % 8));
+    else {
+      value = V();
+      ++column.null_count;
+      column.rejected.push_back(row);
+    }
+    column.values.push_back(value);
+    first = next;
+  }
+  return column;
+}
+
+// raw_decode:
+//
+// the row must conform to the format just as it must in compare. As the
+// digits are checked, the significant ones are gathered into an unsigned
+// long long, m, so that the number is m x base^scale: zeros are held back
+// (pending) until a nonzero digit follows them, so trailing zeros never
+// take up room in m. If m fills up, integers are rejected (the number is
+// then either too large or not an integer); for doubles, the remaining
+// digits are dropped and only scale kept up to date.
+template <typename T, typename U>
+template <typename V>
+bool Basic_Format<T,U>::raw_decode(const char_type* p,
+                                   const char_type* const last,
+                                   Lookup& whole, Lookup& exponent,
+                                   V& value) const {
+  whole.reset();
+  exponent.reset();
+
+  bool negative = false;
+  if (*p == symbols_.plus)
+    ++p;
+  else if (*p == symbols_.minus) {
+    negative = true;
+    ++p;
+  }
+  if ( static_cast<std::size_t>(last - p) < specifier_.length() ||
+       !std::equal(specifier_.begin(), specifier_.end(), p) )
+    return false;
+  p += specifier_.length();
+  const char_type* const exp_position =
+                          std::search(p, last, exp_.begin(), exp_.end());
+
+  const std::size_t base = digits_.size() - 1;  // the decimal point
+  const unsigned long long m_max = static_cast<unsigned long long>(-1);
+  unsigned long long m = 0;
+  width_type scale = 0;
+  std::size_t pending = 0;           // zeros held back...
+  std::size_t pending_fraction = 0;  // ...that are after the decimal point
+  bool decimal = false;
+  bool any = false;
+  bool full = false;
+  Groups groups{ symbols_.group };
+  for (; p != exp_position; ++p) {
+    if ( symbols_.separator != char_type(0) && *p == symbols_.separator ) {
+      if ( decimal || !groups.separator() )
+        return false;
+      continue;
+    }
+    const std::size_t d = whole.find(*p);
+    if (d == Lookup::npos || !whole.count(d))
+      return false;
+    if (d == base) {
+      if ( !groups.end() )
+        return false;
+      decimal = true;
+      continue;
+    }
+    if (!decimal)
+      groups.digit();
+    any = true;
+    if (full) {
+      if (!decimal)
+        ++scale;
+      continue;
+    }
+    if (d == 0) {
+      ++pending;
+      if (decimal)
+        ++pending_fraction;
+      continue;
+    }
+
+    // m = m x base^(pending+1) + d, if it fits
+    unsigned long long n = m;
+    for (std::size_t i = 0; i <= pending && !full; ++i) {
+      if (n > m_max / base)
+        full = true;
+      n *= base;
+    }
+    if (!full && n > m_max - d)
+      full = true;
+    if (full) {
+      if (!std::is_floating_point<V>::value)
+        return false;
+      scale += (pending - pending_fraction) + (decimal ? 0 : 1);
+    }
+    else {
+      m = n + d;
+      if (decimal)
+        scale -= pending_fraction + 1;
+    }
+    pending = pending_fraction = 0;
+  }
+  scale += pending - pending_fraction;
+  if ( !decimal && !groups.end() )
+    return false;
+
+  // a number with no digits: just a decimal point is not a number, and
+  // just an exponent is one times that power
+  if (!any) {
+    if (decimal || exp_position == last)
+      return false;
+    m = 1;
+  }
+
+  if (exp_position != last) {
+    p = exp_position + exp_.length();
+    if (p == last)
+      return false;
+    bool exp_negative = false;
+    if (*p == symbols_.plus)
+      ++p;
+    else if (*p == symbols_.minus) {
+      exp_negative = true;
+      ++p;
+    }
+    if (p == last)
+      return false;
+
+    // exponents too large for a width_type are capped: the number is then
+    // too large, or too small, for any value type anyway
+    const width_type exp_base = exp_digits_.size();
+    const width_type exp_max = width_type(1) << 40;
+    width_type x = 0;
+    for (; p != last; ++p) {
+      const std::size_t d = exponent.find(*p);
+      if (d == Lookup::npos || !exponent.count(d))
+        return false;
+      if (x < exp_max)
+        x = x * exp_base + d;
+    }
+    scale += exp_negative ? -std::min(x, exp_max) : std::min(x, exp_max);
+  }
+
+  return raw_value(m, scale, negative, value);
+}
+
+template <typename T, typename U>
+bool Basic_Format<T,U>::raw_value(unsigned long long m, width_type scale,
+                                  const bool negative,
+                                  std::uint64_t& value) const {
+  if (m == 0) {
+    value = 0;
+    return true;
+  }
+  if (negative)
+    return false;
+  const unsigned long long base = digits_.size() - 1;
+  for (; scale < 0; ++scale, m /= base)
+    if (m % base)
+      return false;
+  for (; scale > 0; --scale, m *= base)
+    if (m > std::numeric_limits<std::uint64_t>::max() / base)
+      return false;
+  value = m;
+  return true;
+}
+
+template <typename T, typename U>
+bool Basic_Format<T,U>::raw_value(unsigned long long m, width_type scale,
+                                  const bool negative,
+                                  std::int64_t& value) const {
+  std::uint64_t magnitude = 0;
+  if (!raw_value(m, scale, false, magnitude))
+    return false;
+  const std::uint64_t max = std::numeric_limits<std::int64_t>::max();
+  if (magnitude > max + (negative ? 1 : 0))
+    return false;
+  value = negative ? static_cast<std::int64_t>(0 - magnitude)
+                   : static_cast<std::int64_t>(magnitude);
+  return true;
+}
+
+// m and the power of the base are usually exact in a long double, so the
+// result is then rounded just once before it is narrowed to a double.
+// Numbers too large for a double are rejected (and too small ones are
+// rounded to zero).
+template <typename T, typename U>
+bool Basic_Format<T,U>::raw_value(unsigned long long m, width_type scale,
+                                  const bool negative, double& value) const {
+  const long double base = digits_.size() - 1;
+  const long double v =
+      scale < 0 ? m / std::pow(base, static_cast<long double>(-scale))
+                : m * std::pow(base, static_cast<long double>(scale));
+  value = static_cast<double>(negative ? -v : v);
+  return !std::isinf(value);
+}
+
+
+
+
+
+
+template <typename T, typename U>
+auto Basic_Format<T,U>::raw_str_to_int
+    (const string& input, const bool digit_list) const -> width_type {
+  width_type ret = 0;
+  const str_size_type input_length = input.length();
+  const typename digits_type::size_type base =
+                            digit_list ? digits_.size()-1 : exp_digits_.size();
+  for (str_size_type i=0; i<input_length; ++i) {
+    for (typename digits_type::size_type j=0; j<base; ++j) {
+      if ( (digit_list ? digits_ : exp_digits_)[j] == input[i]) {
+        ret = ret*base + j;
+        break;
+      }
+    }
+  }
+  return ret;
+}
+
+
+
+// raw_str_to_int: as above, but with the digits looked up in the table
+template <typename T, typename U>
+auto Basic_Format<T,U>::raw_str_to_int
+    (const string& input, const Lookup& lookup,
+     const bool digit_list) const -> width_type {
+  width_type ret = 0;
+  const width_type base =
+                    digit_list ? digits_.size()-1 : exp_digits_.size();
+  for (auto c : input)
+    ret = ret*base + lookup.find(c);
+  return ret;
+}
+
+
+
+template <typename T, typename U>
+template <typename V, typename W>
+void Basic_Format<T,U>::raw_int_to_str
+      (const Basic_Format<V,W>& dest, width_type input,
+       std::basic_string<V>& output, const bool digit_list) const {
+  const typename Basic_Format<V,W>::digits_type& dest_digits =
+                      digit_list ? dest.digits() : dest.exponent_digits();
+  if (input==0) {
+    output += dest_digits.begin()->name();
+    return;
+  }
+  const auto base = digit_list ? dest_digits.size() - 1 : dest_digits.size();
+  // (input is never negative: it is the value of a string of digits)
+  if (static_cast<std::make_unsigned<width_type>::type>(input) < base) {
+    output += dest_digits[input].name();
+    return;
+  }
+
+  // write the digits least significant first, then turn them around
+  const auto start = output.size();
+  for (; input > 0; input /= base)
+    output += dest_digits[input % base].name();
+  std::reverse(output.begin() + start, output.end());
+}
+
+
+
+template <typename T, typename U>
+template <typename V, typename W>
+void Basic_Format<T,U>::raw_convert(const Basic_Format<V,W>& dest,
+                                    const string& input,
+                                    std::basic_string<V>& output,
+                                    const bool digit_list,
+                                    const unsigned threads,
+                                    const Lookup* lookup) const {
+  const std::size_t base =
+                  digit_list ? digits_.size()-1 : exp_digits_.size();
+
+  // numbers that fit in a width_type are converted through one:
+  if ( input.length() * std::log2(base) < 62 ) {
+    const width_type internal_number =
+                              lookup ? raw_str_to_int(input, *lookup, digit_list)
+                                     : raw_str_to_int(input, digit_list);
+    raw_int_to_str(dest, internal_number, output, digit_list);
+    return;
+  }
+
+  // ...and larger ones through a Natural
+  std::vector<std::size_t> values(input.length());
+  for (str_size_type i = 0; i < input.length(); ++i)
+    values[i] = lookup ? lookup->find(input[i])
+                       : raw_digit_value(input[i], digit_list);
+
+  const typename Basic_Format<V,W>::digits_type& dest_digits =
+                      digit_list ? dest.digits() : dest.exponent_digits();
+  const std::size_t dest_base =
+                  digit_list ? dest_digits.size()-1 : dest_digits.size();
+  const std::vector<std::size_t> dest_values =
+      Natural::from_digits(values, base, threads)
+        .to_digits(dest_base, threads);
+  output.reserve(output.size() + dest_values.size());
+  for (auto i = dest_values.begin(); i != dest_values.end(); ++i)
+    output += dest_digits[*i].name();
+}
+
+
+
+
+// raw_to: write [-][specifier][whole][e[-]{exponent}] in the destination
+// format. Each part is written straight into output (in the destination's
+// character type), so no intermediate strings need to be joined.
+template <typename T, typename U>
+template <typename V, typename W>
+void Basic_Format<T,U>::raw_to(const Basic_Format<V,W>& dest,
+                               const Split& s,
+                               std::basic_string<V>& output,
+                               const unsigned threads,
+                               const Lookup* whole,
+                               const Lookup* exponent) const {
+  if (!s.whole_positive)
+    output += dest.symbols().minus;
+  output += dest.specifier();
+  raw_convert(dest, s.whole_part, output, true, threads, whole);
+  if (s.exponent) {
+    output += dest.exponent_specifier();
+    if (!s.exponent_positive)
+      output += dest.symbols().minus;
+    raw_convert(dest, s.exponent_part, output, false, threads, exponent);
+  }
+}
+
+
+
+// raw_fold: the point is moved by the exponent (in this format's base),
+// so that the value of a fraction is kept when it is converted: copying
+// the exponent, as to does for an integer literal, would change it. A
+// fraction with more leading zeros than it takes to be below half a unit
+// in the last of the places (k zeros per place, where base^k is at least
+// the destination's base) is cut to that many zeros and a one, which
+// converts and rounds in the same way.
+template <typename T, typename U>
+bool Basic_Format<T,U>::raw_fold(Split& s, const width_type exponent,
+                                 const std::size_t dest_base,
+                                 const std::size_t places) const {
+  const std::size_t base = digits_.size() - 1;
+  const char_type zero = digits_.begin()->name();
+  const string digits = s.whole_part + s.decimal_part;
+  const width_type length = static_cast<width_type>(digits.length());
+  const width_type room = static_cast<width_type>(std::min<str_size_type>(
+      digits.max_size(),
+      static_cast<str_size_type>(std::numeric_limits<width_type>::max())))
+      - length;
+  // the point, counted from the first of the digits
+  width_type point;
+  if (!raw_checked_add(static_cast<width_type>(s.whole_part.length()),
+                       exponent, point) || point - length > room)
+    return false;
+
+  s.exponent = false;
+  s.exponent_positive = true;
+  s.exponent_part.clear();
+  if (point >= length) {
+    s.whole_part = digits;
+    s.whole_part.append(static_cast<str_size_type>(point - length), zero);
+    s.decimal_part.clear();
+  }
+  else if (point > 0) {
+    s.whole_part.assign(digits, 0, static_cast<str_size_type>(point));
+    s.decimal_part.assign(digits, static_cast<str_size_type>(point),
+                          string::npos);
+  }
+  else {
+    std::size_t k = 1;
+    for (std::size_t power = base; power < dest_base; power *= base)
+      ++k;
+    const width_type enough =
+        places < static_cast<std::size_t>(room) / k - 1 ?
+            static_cast<width_type>((places + 1) * k) : room;
+    s.whole_part.assign(1, zero);
+    if (-point > enough) {
+      s.decimal_part.assign(static_cast<str_size_type>(enough), zero);
+      s.decimal_part += digits_[1].name();
+    }
+    else {
+      s.decimal_part.assign(static_cast<str_size_type>(-point), zero);
+      s.decimal_part += digits;
+    }
+  }
+  // (the whole part keeps one zero, at most, before its first digit)
+  const str_size_type first = s.whole_part.find_first_not_of(zero);
+  s.whole_part.erase(0, first == string::npos ? s.whole_part.length() - 1
+                                              : first);
+  s.decimal = !s.decimal_part.empty();
+  return true;
+}
+
+
+
+// raw_to_places: write [-][specifier][whole][.{fraction}][e[-]{exponent}]
+// in the destination format. The fraction 0.{decimal_part} is multiplied
+// by the destination's base, in place, once for each place: what carries
+// out of it is the next digit, and the trailing zeros that the product
+// ends with are dropped, so the fraction shrinks to nothing (and the
+// digits stop) when it ends in the destination's base. What is left of it
+// after the last place is rounded (in a unit of the last place, which may
+// carry into the whole part).
+template <typename T, typename U>
+template <typename V, typename W>
+void Basic_Format<T,U>::raw_to_places(const Basic_Format<V,W>& dest,
+                                      const Split& s,
+                                      std::basic_string<V>& output,
+                                      const std::size_t places,
+                                      const Rounding mode,
+                                      const unsigned threads) const {
+  const std::size_t base = digits_.size() - 1;
+  const typename Basic_Format<V,W>::digits_type& dest_digits = dest.digits();
+  const std::size_t dest_base = dest_digits.size() - 1;
+
+  std::vector<std::size_t> fraction(s.decimal_part.length());
+  for (str_size_type i = 0; i < s.decimal_part.length(); ++i)
+    fraction[i] = raw_digit_value(s.decimal_part[i]);
+  while (!fraction.empty() && fraction.back() == 0)
+    fraction.pop_back();
+
+  std::vector<std::size_t> digits;
+  while (digits.size() < places && !fraction.empty()) {
+    std::size_t carry = 0;
+    for (std::size_t i = fraction.size(); i-- > 0; ) {
+      const std::size_t product = fraction[i] * dest_base + carry;
+      fraction[i] = product % base;
+      carry = product / base;
+    }
+    digits.push_back(carry);
+    while (!fraction.empty() && fraction.back() == 0)
+      fraction.pop_back();
+  }
+
+  string whole(s.whole_part);
+  if (!fraction.empty()) {
+    // the last digit kept is the last of the places, or, with none, the
+    // last digit of the whole part in the destination's base
+    bool last_odd;
+    if (digits.empty()) {
+      std::size_t last = 0;
+      for (auto c : whole)
+        last = (last * base + raw_digit_value(c)) % dest_base;
+      last_odd = last % 2 == 1;
+    }
+    else
+      last_odd = digits.back() % 2 == 1;
+    if (raw_round_up(mode, raw_against_half(fraction, 0), s.whole_positive,
+                     last_odd)) {
+      std::size_t i = digits.size();
+      while (i > 0 && digits[i - 1] == dest_base - 1)
+        digits[--i] = 0;
+      if (i > 0)
+        ++digits[i - 1];
+      else {
+        // a unit carried into the whole part (in this format's digits)
+        str_size_type j = whole.length();
+        while (j > 0 && raw_digit_value(whole[j - 1]) == base - 1)
+          whole[--j] = digits_.begin()->name();
+        if (j > 0)
+          whole[j - 1] = digits_[raw_digit_value(whole[j - 1]) + 1].name();
+        else
+          whole.insert(whole.begin(), digits_[1].name());
+      }
+    }
+    while (!digits.empty() && digits.back() == 0)
+      digits.pop_back();
+  }
+
+  bool zero = digits.empty();
+  for (auto i = whole.begin(); zero && i != whole.end(); ++i)
+    zero = raw_digit_value(*i) == 0;
+  if (!s.whole_positive && !zero)
+    output += dest.symbols().minus;
+  output += dest.specifier();
+  raw_convert(dest, whole, output, true, threads);
+  if (!digits.empty()) {
+    output += dest.symbols().point;
+    for (auto d : digits)
+      output += dest_digits[d].name();
+  }
+  if (s.exponent) {
+    output += dest.exponent_specifier();
+    if (!s.exponent_positive)
+      output += dest.symbols().minus;
+    raw_convert(dest, s.exponent_part, output, false, threads);
+  }
+}
+
+
+
+template <typename T, typename U>
+auto Basic_Format<T,U>::raw_split(const Basic_Data<T>& data) const -> Split {
+  Split s;
+  raw_split(data, s);
+  return s;
+}
+
+// raw_split: as above, into an existing Split (whose strings are assigned
+// to, so that their capacity is reused)
+template <typename T, typename U>
+void Basic_Format<T,U>::raw_split(const Basic_Data<T>& data,
+                                  Split& s) const {
+  // [-][specifier][whole][.{decimal}][e[-]{exponent}]
+  s.whole_positive = true;
+  s.decimal = false;
+  s.decimal_part.clear();
+  s.exponent = false;
+  s.exponent_positive = true;
+  s.exponent_part.clear();
+
+  str_size_type whole_start = specifier_.length();
+  if (data.normalized[0] == symbols_.minus) {
+    s.whole_positive = data.is_positive;
+    ++whole_start;
+  }
+
+  const str_size_type exp_pos = data.normalized.find(exp_);
+  if (exp_pos != string::npos) {
+    s.exponent = true;
+    str_size_type exp_start = exp_pos + exp_.length();
+    s.exponent_positive = data.is_exponent_positive;
+    if (!s.exponent_positive)
+      ++exp_start;
+    s.exponent_part.assign(data.normalized, exp_start, string::npos);
+  }
+
+  const str_size_type decimal_pos = data.normalized.find(symbols_.point);
+  if (decimal_pos == string::npos) {
+    if (exp_pos == string::npos)
+      s.whole_part.assign(data.normalized, whole_start, string::npos);
+    else
+      s.whole_part.assign(data.normalized, whole_start,
+                          exp_pos-whole_start);
+  }
+  else {
+    s.decimal = true;
+    if (exp_pos == string::npos) {
+      s.whole_part.assign(data.normalized, whole_start,
+                          decimal_pos-whole_start);
+      s.decimal_part.assign(data.normalized, decimal_pos+1, string::npos);
+    }
+    else {
+      s.whole_part.assign(data.normalized, whole_start,
+                          decimal_pos-whole_start);
+      s.decimal_part.assign(data.normalized, decimal_pos+1,
+                            exp_pos-decimal_pos-1);
+    }
+  }
+}
+
+template <typename T, typename U>
+std::size_t Basic_Format<T,U>::raw_digit_value
+    (const char_type c, const bool digit_list) const {
+  const digits_type& list = digit_list ? digits_ : exp_digits_;
+  const std::size_t base = digit_list ? list.size()-1 : list.size();
+  for (std::size_t i = 0; i < base; ++i)
+    if (list[i] == c)
+      return i;
+  return base;
+}
+
+// raw_against_half:
+//
+// in an even base half a unit is the digit base/2 followed by zeros, and in
+// an odd base it is the digit (base-1)/2 repeated forever, which no finite
+// string of digits equals.
+template <typename T, typename U>
+int Basic_Format<T,U>::raw_against_half(const std::vector<std::size_t>& digits,
+                                        std::size_t i) const {
+  const std::size_t base = digits_.size() - 1;
+  const std::size_t half = base / 2;
+  if (base % 2 == 0) {
+    if (digits[i] != half)
+      return digits[i] > half ? 1 : -1;
+    return i + 1 < digits.size() ? 1 : 0;
+  }
+  while (i < digits.size() && digits[i] == half)
+    ++i;
+  return i < digits.size() && digits[i] > half ? 1 : -1;
+}
+
+template <typename T, typename U>
+bool Basic_Format<T,U>::raw_round_up(const Rounding mode,
+                                     const int against_half,
+                                     const bool positive,
+                                     const bool last_odd) {
+  switch (mode) {
+  case Rounding::nearest_even:
+    return against_half > 0 || (against_half == 0 && last_odd);
+  case Rounding::nearest_away:
+    return against_half >= 0;
+  case Rounding::toward_zero:
+    return false;
+  case Rounding::away_from_zero:
+    return true;
+  case Rounding::toward_positive:
+    return positive;
+  case Rounding::toward_negative:
+    return !positive;
+  }
+  return false;
+}
+
+// raw_round:
+//
+// round the (non-zero) number in scientific form to its first `keep'
+// digits, which may be none (or fewer than none: the number is then less
+// than a unit in the last place kept, and rounds to zero or to that unit).
+// The digits dropped are compared to half a unit in the last place kept.
+template <typename T, typename U>
+bool Basic_Format<T,U>::raw_round(Scientific& sci, const width_type keep,
+                                  const Rounding mode) const {
+  if (sci.zero || keep >= static_cast<width_type>(sci.digits.size()))
+    return true;
+
+  const std::size_t base = digits_.size() - 1;
+  // compare the dropped digits to half a unit: -1, 0 or 1
+  const int against_half =
+      keep >= 0 ? raw_against_half(sci.digits, static_cast<std::size_t>(keep))
+                : -1;
+
+  const bool last_odd = keep > 0 && sci.digits[keep - 1] % 2 == 1;
+  const bool up = raw_round_up(mode, against_half, sci.positive, last_odd);
+
+  if (keep <= 0) {
+    sci.digits.clear();
+    if (up) {
+      // a unit in the last place kept, at sci.exponent - keep
+      width_type unit_exponent;
+      if (!raw_checked_subtract(sci.exponent, keep, unit_exponent) ||
+          !raw_checked_add(unit_exponent, 1, unit_exponent))
+        return false;
+      sci.digits.push_back(1);
+      sci.exponent = unit_exponent;
+    }
+  }
+  else {
+    sci.digits.resize(keep);
+    if (up) {
+      // add a unit in the last place, carrying as far as need be
+      std::size_t i = sci.digits.size();
+      while (i > 0 && sci.digits[i - 1] == base - 1)
+        sci.digits[--i] = 0;
+      if (i == 0) {
+        sci.digits.insert(sci.digits.begin(), 1);
+        ++sci.exponent;
+      }
+      else
+        ++sci.digits[i - 1];
+    }
+  }
+  while (!sci.digits.empty() && sci.digits.back() == 0)
+    sci.digits.pop_back();
+  if (sci.digits.empty()) {
+    sci.zero = true;
+    sci.positive = true;
+    sci.exponent = 0;
+  }
+  return true;
+}
+
+
+
+// raw_format:
+//
+// write the number in scientific form as a normalized string of this
+// format with its scale as the exponent, so that its digits are the number
+// over base^scale: [-][specifier][whole][.{fraction}][e[-]{scale}]. If
+// the format limits its digits, the string is checked as compare checks
+// it, and is empty if it uses one too often.
+template <typename T, typename U>
+auto Basic_Format<T,U>::raw_format(const Scientific& sci) const -> string {
+  string output;
+  raw_format(sci, output);
+  return output;
+}
+
+// raw_format: as above, replacing the contents of the output string
+template <typename T, typename U>
+void Basic_Format<T,U>::raw_format(const Scientific& sci,
+                                   string& output) const {
+  output.clear();
+  if (sci.zero) {
+    output += specifier_;
+    output += digits_.begin()->name();
+    return;
+  }
+
+  // the number of digits before the point (a number whose zeros could not
+  // be held in a string is left empty)
+  const width_type whole = sci.exponent;
+  const width_type length = static_cast<width_type>(sci.digits.size());
+  const width_type room = static_cast<width_type>(std::min<str_size_type>(
+      output.max_size(),
+      static_cast<str_size_type>(std::numeric_limits<width_type>::max())))
+      - length;
+  if (whole > room || whole < -room)
+    return;
+
+  if (!sci.positive)
+    output += symbols_.minus;
+  output += specifier_;
+  if (whole <= 0) {
+    output += digits_.begin()->name();
+    output += symbols_.point;
+    output.append(static_cast<str_size_type>(-whole),
+                  digits_.begin()->name());
+    for (auto i = sci.digits.begin(); i != sci.digits.end(); ++i)
+      output += digits_[*i].name();
+  }
+  else {
+    for (width_type i = 0; i < length; ++i) {
+      if (i == whole)
+        output += symbols_.point;
+      output += digits_[sci.digits[i]].name();
+    }
+    if (whole > length)
+      output.append(static_cast<str_size_type>(whole - length),
+                    digits_.begin()->name());
+  }
+
+  if (sci.scale != 0) {
+    output += exp_;
+    if (sci.scale < 0)
+      output += symbols_.minus;
+    raw_int_to_str(*this, sci.scale < 0 ? -sci.scale : sci.scale, output,
+                   false);
+  }
+  // a number that uses a digit more times than the format allows is not
+  // one of its numbers, so it is left empty
+  if (raw_counted() && !compare(output).is_number)
+    output.clear();
+}
+
+
+
+// raw_scientific:
+//
+// data.whole_string_normalized is [-][specifier]{digits}[.{digits}] with
+// no leading zeros before the first nonzero digit (bar one before the
+// decimal point) and no trailing zeros after the decimal point; so, after
+// dropping any leading and trailing zeros that remain, the scientific
+// exponent is the number of digits before the decimal point, less the
+// leading zeros dropped; the exponent of the input is the scale.
+template <typename T, typename U>
+void Basic_Format<T,U>::raw_scientific(const Basic_Data<T>& data,
+                                       Scientific& sci) const {
+  // (the digits are cleared, not replaced, so their capacity is reused)
+  sci.zero = true;
+  sci.positive = true;
+  sci.exponent = 0;
+  sci.scale = 0;
+  sci.digits.clear();
+  if (!data.is_number || data.is_zero)
+    return;
+  sci.zero = false;
+  sci.positive = data.is_positive;
+
+  const string& w = data.whole_string_normalized;
+  str_size_type i = specifier_.length() + (data.is_positive ? 0 : 1);
+  width_type whole_digits = 0;
+  bool decimal = false;
+  sci.digits.reserve(w.length() - i);
+  for (; i < w.length(); ++i) {
+    if ( w[i] == symbols_.point ) {
+      decimal = true;
+      continue;
+    }
+    const std::size_t value = raw_digit_value(w[i]);
+    if (sci.digits.empty() && value == 0) {
+      // a leading zero
+      if (!decimal)
+        continue;
+      --sci.exponent;
+    }
+    else
+      sci.digits.push_back(value);
+    if (!decimal)
+      ++whole_digits;
+  }
+  while (!sci.digits.empty() && sci.digits.back() == 0)
+    sci.digits.pop_back();
+  sci.exponent += whole_digits;
+  sci.scale = data.exponent_width;
+}
+
+template <typename T, typename U>
+int Basic_Format<T,U>::raw_order(const Scientific& a,
+                                 const Scientific& b) const {
+  // the sign class of each number: -1, 0 or 1
+  const int ca = a.zero ? 0 : (a.positive ? 1 : -1);
+  const int cb = b.zero ? 0 : (b.positive ? 1 : -1);
+  if (ca != cb)
+    return ca < cb ? -1 : 1;
+  if (ca == 0)
+    return 0;
+
+  // the same sign: compare the magnitudes, then flip for negatives.
+  return ca * raw_order_magnitude(a, b);
+}
+
+template <typename T, typename U>
+int Basic_Format<T,U>::raw_order_magnitude(const Scientific& a,
+                                           const Scientific& b) {
+  const int power = raw_order_exponent(a, b);
+  if (power != 0)
+    return power;
+  const std::size_t n = std::min(a.digits.size(), b.digits.size());
+  for (std::size_t i = 0; i < n; ++i)
+    if (a.digits[i] != b.digits[i])
+      return a.digits[i] < b.digits[i] ? -1 : 1;
+  if (a.digits.size() != b.digits.size())
+    return a.digits.size() < b.digits.size() ? -1 : 1;
+  return 0;
+}
+
+
+
+// raw_order_exponent: exponent + scale is compared without working it out.
+// Numbers of the same scale compare by exponent; otherwise the exponents
+// are those of raw_scientific, at most the lengths of the strings, and
+// a.exponent + a.scale < b.exponent + b.scale iff
+// a.scale - b.scale < b.exponent - a.exponent, where only the difference
+// of the scales can overflow (and if it does, it decides).
+template <typename T, typename U>
+int Basic_Format<T,U>::raw_order_exponent(const Scientific& a,
+                                          const Scientific& b) noexcept {
+  if (a.scale == b.scale)
+    return a.exponent == b.exponent ? 0 : (a.exponent < b.exponent ? -1 : 1);
+  width_type scales;
+  if (!raw_checked_subtract(a.scale, b.scale, scales))
+    return a.scale < b.scale ? -1 : 1;
+  const width_type exponents = b.exponent - a.exponent;
+  return scales == exponents ? 0 : (scales < exponents ? -1 : 1);
+}
+
+
+
+// raw_add:
+//
+// the digits of both numbers are laid out in the result by their weights:
+// the digit at index k has the weight base^(high-k), where high is the
+// larger exponent (so index 0 is left free for a carry), down to the
+// weight of the lower of the numbers' last digits. The numbers are then
+// added, or the smaller magnitude taken from the larger, from the last
+// digit up, carrying or borrowing one at a time. Nothing is laid out if
+// the result's exponent, or the span of the weights, would not fit in a
+// width_type.
+template <typename T, typename U>
+bool Basic_Format<T,U>::raw_add(const Scientific& a, const Scientific& b,
+                                const bool subtract,
+                                Scientific& result) const {
+  const bool b_positive = subtract ? !b.positive : b.positive;
+  if (a.zero || b.zero) {
+    const Scientific& other = a.zero ? b : a;
+    result.zero = other.zero;
+    result.positive = a.zero ? b_positive || b.zero : a.positive;
+    result.exponent = other.exponent;
+    result.digits.assign(other.digits.begin(), other.digits.end());
+    return true;
+  }
+
+  const std::size_t base = digits_.size() - 1;
+  const width_type high = std::max(a.exponent, b.exponent);
+  width_type low_a, low_b, span;
+  if (!raw_checked_subtract(a.exponent,
+                            static_cast<width_type>(a.digits.size()), low_a) ||
+      !raw_checked_subtract(b.exponent,
+                            static_cast<width_type>(b.digits.size()), low_b) ||
+      !raw_checked_subtract(high, std::min(low_a, low_b), span) ||
+      high == std::numeric_limits<width_type>::max())
+    return false;
+  const std::size_t length = static_cast<std::size_t>(span) + 1;
+  // the index of the first digit of a number
+  auto first = [high](const Scientific& n) {
+    return static_cast<std::size_t>(high - n.exponent) + 1;
+  };
+
+  result.zero = false;
+  result.exponent = high + 1;
+  std::vector<std::size_t>& d = result.digits;
+  if (a.positive == b_positive) {
+    result.positive = a.positive;
+    d.assign(length, 0);
+    std::copy(a.digits.begin(), a.digits.end(), d.begin() + first(a));
+    for (std::size_t i = 0, k = first(b); i < b.digits.size(); ++i, ++k)
+      d[k] += b.digits[i];
+    for (std::size_t k = length - 1; k > 0; --k)
+      if (d[k] >= base) {
+        d[k] -= base;
+        ++d[k - 1];
+      }
+  }
+  else {
+    const int magnitude = raw_order_magnitude(a, b);
+    if (magnitude == 0) {
+      result.zero = true;
+      result.positive = true;
+      result.exponent = 0;
+      d.clear();
+      return true;
+    }
+    const Scientific& larger = magnitude > 0 ? a : b;
+    const Scientific& smaller = magnitude > 0 ? b : a;
+    result.positive = magnitude > 0 ? a.positive : b_positive;
+    d.assign(length, 0);
+    std::copy(larger.digits.begin(), larger.digits.end(),
+              d.begin() + first(larger));
+    const std::size_t start = first(smaller);
+    std::size_t borrow = 0;
+    for (std::size_t k = length; k-- > 0 && (borrow || k >= start); ) {
+      std::size_t take = borrow;
+      if (k >= start && k - start < smaller.digits.size())
+        take += smaller.digits[k - start];
+      borrow = d[k] < take ? 1 : 0;
+      d[k] = d[k] + borrow * base - take;
+    }
+  }
+  raw_trim(result);
+  return true;
+}
+
+// raw_multiply: long multiplication, the product of the digits at indices
+// i and j of the numbers falling at index i+j+1 of the result (whose
+// exponent is the sum of theirs), a row for each digit of the first
+template <typename T, typename U>
+void Basic_Format<T,U>::raw_multiply(const Scientific& a,
+                                     const Scientific& b,
+                                     Scientific& result) const {
+  if (a.zero || b.zero) {
+    result.zero = true;
+    result.positive = true;
+    result.exponent = 0;
+    result.digits.clear();
+    return;
+  }
+
+  const std::size_t base = digits_.size() - 1;
+  std::vector<std::size_t>& d = result.digits;
+  d.assign(a.digits.size() + b.digits.size(), 0);
+  for (std::size_t i = a.digits.size(); i-- > 0; ) {
+    std::size_t carry = 0;
+    for (std::size_t j = b.digits.size(); j-- > 0; ) {
+      const std::size_t t = d[i + j + 1] + a.digits[i] * b.digits[j] + carry;
+      d[i + j + 1] = t % base;
+      carry = t / base;
+    }
+    d[i] = carry;
+  }
+  result.zero = false;
+  result.positive = a.positive == b.positive;
+  result.exponent = a.exponent + b.exponent;
+  raw_trim(result);
+}
+
+template <typename T, typename U>
+bool Basic_Format<T,U>::raw_checked_add(const width_type a,
+                                        const width_type b,
+                                        width_type& sum) noexcept {
+  typedef std::numeric_limits<width_type> limits;
+  if ((b > 0 && a > limits::max() - b) || (b < 0 && a < limits::min() - b))
+    return false;
+  sum = a + b;
+  return true;
+}
+
+template <typename T, typename U>
+bool Basic_Format<T,U>::raw_checked_subtract(const width_type a,
+                                             const width_type b,
+                                             width_type& difference) noexcept {
+  typedef std::numeric_limits<width_type> limits;
+  if ((b < 0 && a > limits::max() + b) || (b > 0 && a < limits::min() + b))
+    return false;
+  difference = a - b;
+  return true;
+}
+
+template <typename T, typename U>
+void Basic_Format<T,U>::raw_trim(Scientific& sci) {
+  std::size_t leading = 0;
+  while (leading < sci.digits.size() && sci.digits[leading] == 0)
+    ++leading;
+  sci.digits.erase(sci.digits.begin(), sci.digits.begin() + leading);
+  sci.exponent -= static_cast<width_type>(leading);
+  while (!sci.digits.empty() && sci.digits.back() == 0)
+    sci.digits.pop_back();
+  if (sci.digits.empty()) {
+    sci.zero = true;
+    sci.positive = true;
+    sci.exponent = 0;
+  }
+}
+
+// raw_arithmetic: the exponent of a sum or difference is the smaller of
+// the operands' (so that neither needs a point that it did not have), and
+// that of a product the sum of theirs. The operands keep their exponents
+// as their scales, apart from their digits, and the result is given the
+// exponent of the operation as its scale, so that only the scales
+// themselves can overflow: if one would (or the scale is the one
+// width_type without a negation), the output is empty.
+template <typename T, typename U>
+void Basic_Format<T,U>::raw_arithmetic(const Operation operation,
+                                       const Basic_Data<T>& a,
+                                       const Basic_Data<T>& b,
+                                       string& output,
+                                       Context& context) const {
+  if (!a.is_number || !b.is_number) {
+    output.clear();
+    return;
+  }
+  Scientific& result = context.result_;
+  width_type exponent = a.exponent_width;
+  bool fits = true;
+  if (operation == Operation::negate) {
+    raw_scientific(a, result);
+    result.positive = result.zero || !result.positive;
+  }
+  else {
+    raw_scientific(a, context.lhs_);
+    raw_scientific(b, context.rhs_);
+    if (operation == Operation::multiply) {
+      raw_multiply(context.lhs_, context.rhs_, result);
+      // (a zero is written without an exponent)
+      fits = result.zero ||
+             raw_checked_add(exponent, b.exponent_width, exponent);
+    }
+    else {
+      exponent = std::min(exponent, b.exponent_width);
+      // an operand moved to the scale of the sum: its exponent goes up by
+      // the amount its own scale is above the sum's
+      auto shift = [exponent](Scientific& sci) {
+        width_type by;
+        if (sci.zero || !raw_checked_subtract(sci.scale, exponent, by) ||
+            !raw_checked_add(sci.exponent, by, sci.exponent))
+          return sci.zero;
+        sci.scale = exponent;
+        return true;
+      };
+      fits = shift(context.lhs_) && shift(context.rhs_) &&
+             raw_add(context.lhs_, context.rhs_,
+                     operation == Operation::subtract, result);
+    }
+  }
+  if (!fits || (!result.zero &&
+                exponent == std::numeric_limits<width_type>::min())) {
+    output.clear();
+    return;
+  }
+  result.scale = exponent;
+  raw_format(result, output);
+}
+
+template <typename T, typename U>
+bool Basic_Format<T,U>::raw_counted() const {
+  const count_type unlimited = static_cast<count_type>(-1);
+  // (the point, the last of the digits, may be used once)
+  for (auto i = digits_.begin(); i + 1 < digits_.end(); ++i)
+    if (i->count_max() != unlimited)
+      return true;
+  for (auto i = exp_digits_.begin(); i != exp_digits_.end(); ++i)
+    if (i->count_max() != unlimited)
+      return true;
+  return false;
+}
+
+template <typename T, typename U>
+auto Basic_Format<T,U>::raw_whole_characters() const
+    -> std::vector<char_type> {
+  std::vector<char_type> chars;
+  for (auto i = digits_.begin(); i != digits_.end(); ++i)
+    chars.push_back(i->name());
+  if (symbols_.separator != char_type(0))
+    chars.push_back(symbols_.separator);
+  if (exp_.length() == 1)
+    chars.erase(std::remove(chars.begin(), chars.end(), exp_[0]),
+                chars.end());
+  return chars;
+}
+
+
+
+
+
+// -- class Basic_Predefined_Format --------------
+// ctor: Basic_Predefined_Format(<...>)
+template <typename T, typename U>
+template <std::size_t N, std::size_t M, std::size_t DN, std::size_t EN>
+constexpr Basic_Predefined_Format<T,U>::Basic_Predefined_Format
+    (const char_type (&specifier)[N],
+     const digit_type (&digits)[DN],
+     const char_type (&exp_string)[M],
+     const digit_type (&exp_digits)[EN])
+  : specifier_        {specifier},
+    specifier_length_ {N-1},
+    digits_           {digits},
+    exp_              {exp_string},
+    exp_length_       {M-1},
+    exp_digits_       {exp_digits},
+    format_           {nullptr},
+    mutex_            {},
+    storage_          {}
+{}
+
+// get: the Basic_Format, built on first use
+template <typename T, typename U>
+auto Basic_Predefined_Format<T,U>::get() const -> const format_type& {
+  const format_type* f = format_.load(std::memory_order_acquire);
+  if (f)
+    return *f;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  f = format_.load(std::memory_order_relaxed);
+  if (!f) {
+    f = new (&storage_) format_type{ string(specifier_, specifier_length_),
+                                     digits_,
+                                     string(exp_, exp_length_),
+                                     exp_digits_ };
+    format_.store(f, std::memory_order_release);
+  }
+  return *f;
+}
+
+template <typename T, typename U>
+Basic_Predefined_Format<T,U>::operator const format_type&() const {
+  return get();
+}
+
+template <typename T, typename U>
+auto Basic_Predefined_Format<T,U>::specifier() const -> const string& {
+  return get().specifier();
+}
+
+template <typename T, typename U>
+auto Basic_Predefined_Format<T,U>::digits() const -> const digits_type& {
+  return get().digits();
+}
+
+template <typename T, typename U>
+auto Basic_Predefined_Format<T,U>::exponent_specifier() const
+    -> const string& {
+  return get().exponent_specifier();
+}
+
+template <typename T, typename U>
+auto Basic_Predefined_Format<T,U>::exponent_digits() const
+    -> const digits_type& {
+  return get().exponent_digits();
+}
+
+template <typename T, typename U>
+template <typename... Args>
+auto Basic_Predefined_Format<T,U>::compare(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .compare(std::forward<Args>(args)...)) {
+  return get().compare(std::forward<Args>(args)...);
+}
+
+template <typename T, typename U>
+template <typename... Args>
+auto Basic_Predefined_Format<T,U>::to(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .to(std::forward<Args>(args)...)) {
+  return get().to(std::forward<Args>(args)...);
+}
+
+template <typename T, typename U>
+template <typename... Args>
+auto Basic_Predefined_Format<T,U>::order(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .order(std::forward<Args>(args)...)) {
+  return get().order(std::forward<Args>(args)...);
+}
+
+template <typename T, typename U>
+template <typename... Args>
+auto Basic_Predefined_Format<T,U>::sort_key(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .sort_key(std::forward<Args>(args)...)) {
+  return get().sort_key(std::forward<Args>(args)...);
+}
+
+template <typename T, typename U>
+template <typename... Args>
+auto Basic_Predefined_Format<T,U>::value(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .value(std::forward<Args>(args)...)) {
+  return get().value(std::forward<Args>(args)...);
+}
+
+template <typename T, typename U>
+template <typename... Args>
+auto Basic_Predefined_Format<T,U>::hash(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .hash(std::forward<Args>(args)...)) {
+  return get().hash(std::forward<Args>(args)...);
+}
+
+template <typename T, typename U>
+template <typename... Args>
+auto Basic_Predefined_Format<T,U>::round(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .round(std::forward<Args>(args)...)) {
+  return get().round(std::forward<Args>(args)...);
+}
+
+template <typename T, typename U>
+template <typename... Args>
+auto Basic_Predefined_Format<T,U>::round_places(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .round_places(std::forward<Args>(args)...)) {
+  return get().round_places(std::forward<Args>(args)...);
+}
+
+template <typename T, typename U>
+template <typename... Args>
+auto Basic_Predefined_Format<T,U>::truncate(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .truncate(std::forward<Args>(args)...)) {
+  return get().truncate(std::forward<Args>(args)...);
+}
+
+template <typename T, typename U>
+template <typename... Args>
+auto Basic_Predefined_Format<T,U>::parse(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .parse(std::forward<Args>(args)...)) {
+  return get().parse(std::forward<Args>(args)...);
+}
+
+template <typename T, typename U>
+template <typename... Args>
+auto Basic_Predefined_Format<T,U>::convert(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .convert(std::forward<Args>(args)...)) {
+  return get().convert(std::forward<Args>(args)...);
+}
+
+template <typename T, typename U>
+template <typename... Args>
+auto Basic_Predefined_Format<T,U>::to_batch(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .to_batch(std::forward<Args>(args)...)) {
+  return get().to_batch(std::forward<Args>(args)...);
+}
+
+template <typename T, typename U>
+template <typename... Args>
+auto Basic_Predefined_Format<T,U>::compare_into(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .compare_into(std::forward<Args>(args)...)) {
+  return get().compare_into(std::forward<Args>(args)...);
+}
+
+template <typename T, typename U>
+template <typename... Args>
+auto Basic_Predefined_Format<T,U>::to_into(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .to_into(std::forward<Args>(args)...)) {
+  return get().to_into(std::forward<Args>(args)...);
+}
+
+template <typename T, typename U>
+template <typename... Args>
+auto Basic_Predefined_Format<T,U>::to_places(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .to_places(std::forward<Args>(args)...)) {
+  return get().to_places(std::forward<Args>(args)...);
+}
+template <typename T, typename U>
+template <typename... Args>
+auto Basic_Predefined_Format<T,U>::pattern(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .pattern(std::forward<Args>(args)...)) {
+  return get().pattern(std::forward<Args>(args)...);
+}
+
+template <typename T, typename U>
+template <typename... Args>
+auto Basic_Predefined_Format<T,U>::pattern_exact(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .pattern_exact(std::forward<Args>(args)...)) {
+  return get().pattern_exact(std::forward<Args>(args)...);
+}
+
+template <typename T, typename U>
+template <typename... Args>
+auto Basic_Predefined_Format<T,U>::automaton(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .automaton(std::forward<Args>(args)...)) {
+  return get().automaton(std::forward<Args>(args)...);
+}
+
+template <typename T, typename U>
+template <typename... Args>
+auto Basic_Predefined_Format<T,U>::add(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .add(std::forward<Args>(args)...)) {
+  return get().add(std::forward<Args>(args)...);
+}
+template <typename T, typename U>
+template <typename... Args>
+auto Basic_Predefined_Format<T,U>::subtract(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .subtract(std::forward<Args>(args)...)) {
+  return get().subtract(std::forward<Args>(args)...);
+}
+template <typename T, typename U>
+template <typename... Args>
+auto Basic_Predefined_Format<T,U>::multiply(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .multiply(std::forward<Args>(args)...)) {
+  return get().multiply(std::forward<Args>(args)...);
+}
+template <typename T, typename U>
+template <typename... Args>
+auto Basic_Predefined_Format<T,U>::negate(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .negate(std::forward<Args>(args)...)) {
+  return get().negate(std::forward<Args>(args)...);
+}
+template <typename T, typename U>
+template <typename... Args>
+auto Basic_Predefined_Format<T,U>::sign(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .sign(std::forward<Args>(args)...)) {
+  return get().sign(std::forward<Args>(args)...);
+}
+template <typename T, typename U>
+template <typename... Args>
+auto Basic_Predefined_Format<T,U>::add_into(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .add_into(std::forward<Args>(args)...)) {
+  return get().add_into(std::forward<Args>(args)...);
+}
+template <typename T, typename U>
+template <typename... Args>
+auto Basic_Predefined_Format<T,U>::subtract_into(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .subtract_into(std::forward<Args>(args)...)) {
+  return get().subtract_into(std::forward<Args>(args)...);
+}
+template <typename T, typename U>
+template <typename... Args>
+auto Basic_Predefined_Format<T,U>::multiply_into(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .multiply_into(std::forward<Args>(args)...)) {
+  return get().multiply_into(std::forward<Args>(args)...);
+}
+template <typename T, typename U>
+template <typename... Args>
+auto Basic_Predefined_Format<T,U>::negate_into(Args&&... args) const
+    -> decltype(std::declval<const format_type&>()
+                  .negate_into(std::forward<Args>(args)...)) {
+  return get().negate_into(std::forward<Args>(args)...);
+}
+
+
+
+
+
+// -- class Basic_Predefined_Translation --------------
+// ctor: Basic_Predefined_Translation(const char_type (&)[N], <...>)
+template <typename T>
+template <std::size_t N>
+constexpr Basic_Predefined_Translation<T>::Basic_Predefined_Translation
+    (const char_type (&from)[N], const char_type (&to)[N])
+  : from_        {from},
+    to_          {to},
+    size_        {N-1},
+    translation_ {nullptr},
+    mutex_       {},
+    storage_     {}
+{}
+
+template <typename T>
+auto Basic_Predefined_Translation<T>::normalize(const char_type c) const
+    -> char_type {
+  for (size_type i = 0; i < size_; ++i)
+    if (from_[i] == c)
+      return to_[i];
+  return c;
+}
+
+// get: the translation as a set of congruences, built on first use. Every
+// character that translates into the same character belongs to the same
+// congruence, with that character as the default.
+template <typename T>
+auto Basic_Predefined_Translation<T>::get() const
+    -> const translation_type& {
+  const translation_type* t = translation_.load(std::memory_order_acquire);
+  if (t)
+    return *t;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  t = translation_.load(std::memory_order_relaxed);
+  if (!t) {
+    translation_type* built = new (&storage_) translation_type{};
+    for (size_type i = 0; i < size_; ++i) {
+      typename congruence_type::set set{ to_[i] };
+      for (size_type j = 0; j < size_; ++j)
+        if (to_[j] == to_[i])
+          set.insert(from_[j]);
+      built->insert(congruence_type{ set, to_[i] });
+    }
+    t = built;
+    translation_.store(t, std::memory_order_release);
+  }
+  return *t;
+}
+
+template <typename T>
+Basic_Predefined_Translation<T>::operator const translation_type&() const {
+  return get();
+}
+
+
+
+
+// -- template function translate (pre-defined translations) -------------
+template <typename T>
+std::basic_string<T>
+translate(const std::basic_string<T>& input,
+          const Basic_Predefined_Translation<T>& translation) {
+  std::basic_string<T> output;
+  output.reserve( input.size() );
+  for (auto string_char : input)
+    output += translation.normalize(string_char);
+  return output;
+}
+
+
+
+
+
+// -- class Basic_Numeric_Less --------------
+// ctor: Basic_Numeric_Less(const format_type&)
+template <typename T, typename U>
+Basic_Numeric_Less<T,U>::Basic_Numeric_Less(const format_type& format)
+  : format_ {format} {}
+
+template <typename T, typename U>
+bool Basic_Numeric_Less<T,U>::operator()(const string& a,
+                                         const string& b) const {
+  return format_.order(a, b) < 0;
+}
+
+
+
+
+
+// -- class Intern_Table --------------
+template <typename TFormat>
+auto Intern_Table::intern(const TFormat& format,
+                          const typename TFormat::string& input) -> id_type {
+  return intern(format.value(input));
+}
+
+template <typename TFormat>
+auto Intern_Table::find(const TFormat& format,
+                        const typename TFormat::string& input) const
+    -> id_type {
+  return find(format.value(input));
+}
+
+
+
+
+
+// -- class Basic_Cached_Format --------------
+// the cache key: the destination format of a `to' (nullptr for a
+// `compare') and the input string
+template <typename T, typename U>
+struct Basic_Cached_Format<T,U>::Key {
+  const format_type*  dest;
+  string              input;
+
+  bool operator==(const Key& k) const {
+    return dest == k.dest && input == k.input;
+  }
+};
+
+template <typename T, typename U>
+struct Basic_Cached_Format<T,U>::Key_Hash {
+  std::size_t operator()(const Key& k) const {
+    return std::hash<string>()(k.input)
+           ^ (std::hash<const format_type*>()(k.dest) << 1);
+  }
+};
+
+// struct Clock: a bounded table of results evicted in CLOCK order. Every
+// slot has a `referenced' bit that is set when the slot is hit; when a slot
+// is needed, the hand sweeps round the slots clearing the bits and stops at
+// the first slot whose bit was already clear.
+template <typename T, typename U>
+template <typename V>
+struct Basic_Cached_Format<T,U>::Clock {
+  typedef std::unordered_map<Key, size_type, Key_Hash>  index_type;
+
+  struct Slot {
+    const Key*  key;         // points into the index (nodes are stable)
+    V           value;
+    bool        referenced;
+  };
+
+  index_type         index;
+  std::vector<Slot>  slots;
+  size_type          hand = 0;
+
+  // copy the value for k into v and return true if it is in the table
+  bool find(const Key& k, V& v) {
+    const typename index_type::const_iterator i = index.find(k);
+    if (i == index.end())
+      return false;
+    Slot& slot = slots[i->second];
+    slot.referenced = true;
+    v = slot.value;
+    return true;
+  }
+
+  // add a value for k, evicting another value if the table is full; return
+  // the number of values evicted
+  unsigned long long insert(const Key& k, const V& v,
+                            const size_type capacity) {
+    if (capacity == 0 || index.find(k) != index.end())
+      return 0;
+    if (slots.size() < capacity) {
+      const auto i = index.emplace(k, slots.size()).first;
+      slots.push_back(Slot{ &i->first, v, false });
+      return 0;
+    }
+    while (slots[hand].referenced) {
+      slots[hand].referenced = false;
+      hand = (hand + 1) % slots.size();
+    }
+    Slot& slot = slots[hand];
+    // (erase by position: erasing by key would pass a reference into the
+    // very node being erased)
+    index.erase(index.find(*slot.key));
+    const auto i = index.emplace(k, hand).first;
+    slot.key = &i->first;
+    slot.value = v;
+    hand = (hand + 1) % slots.size();
+    return 1;
+  }
+
+  void clear() {
+    index.clear();
+    slots.clear();
+    hand = 0;
+  }
+};
+
+template <typename T, typename U>
+struct Basic_Cached_Format<T,U>::Shard {
+  std::mutex          mutex;
+  Clock<data_type>    compared;
+  Clock<string>       converted;
+  unsigned long long  hits = 0;
+  unsigned long long  misses = 0;
+  unsigned long long  evictions = 0;
+};
+
+// ctor: Basic_Cached_Format(const format_type&, <...>)
+template <typename T, typename U>
+Basic_Cached_Format<T,U>::Basic_Cached_Format(const format_type& format,
+                                              const size_type capacity,
+                                              const size_type shards)
+  : format_         {format},
+    shard_capacity_ {0},
+    shard_count_    {shards ? shards : 1},
+    shards_         (shard_count_)
+{
+  shard_capacity_ = (capacity + shard_count_ - 1) / shard_count_;
+}
+
+template <typename T, typename U>
+Basic_Cached_Format<T,U>::~Basic_Cached_Format() {}
+
+template <typename T, typename U>
+auto Basic_Cached_Format<T,U>::format() const -> const format_type& {
+  return format_;
+}
+
+template <typename T, typename U>
+auto Basic_Cached_Format<T,U>::raw_shard(const string& input) const
+    -> Shard& {
+  return shards_[std::hash<string>()(input) % shard_count_];
+}
+
+// compare: the memoized Basic_Format::compare. The wrapped format is called
+// without holding the shard's lock, so a slow parse doesn't hold up other
+// threads (two threads missing on the same input will both parse it, and
+// the second result is discarded).
+template <typename T, typename U>
+auto Basic_Cached_Format<T,U>::compare(const string& input) const
+    -> data_type {
+  Shard& shard = raw_shard(input);
+  const Key key{ nullptr, input };
+  data_type data;
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (shard.compared.find(key, data)) {
+      ++shard.hits;
+      return data;
+    }
+    ++shard.misses;
+  }
+  data = format_.compare(input);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  shard.evictions += shard.compared.insert(key, data, shard_capacity_);
+  return data;
+}
+
+// to: the memoized Basic_Format::to
+template <typename T, typename U>
+auto Basic_Cached_Format<T,U>::to(const format_type& dest,
+                                  const string& input) const -> string {
+  Shard& shard = raw_shard(input);
+  const Key key{ &dest, input };
+  string converted;
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (shard.converted.find(key, converted)) {
+      ++shard.hits;
+      return converted;
+    }
+    ++shard.misses;
+  }
+  converted = format_.to(dest, input);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  shard.evictions += shard.converted.insert(key, converted, shard_capacity_);
+  return converted;
+}
+
+template <typename T, typename U>
+auto Basic_Cached_Format<T,U>::statistics() const -> Statistics {
+  Statistics stats{ 0, 0, 0 };
+  for (size_type i = 0; i < shard_count_; ++i) {
+    std::lock_guard<std::mutex> lock(shards_[i].mutex);
+    stats.hits += shards_[i].hits;
+    stats.misses += shards_[i].misses;
+    stats.evictions += shards_[i].evictions;
+  }
+  return stats;
+}
+
+template <typename T, typename U>
+void Basic_Cached_Format<T,U>::clear() {
+  for (size_type i = 0; i < shard_count_; ++i) {
+    std::lock_guard<std::mutex> lock(shards_[i].mutex);
+    shards_[i].compared.clear();
+    shards_[i].converted.clear();
+  }
+}
+
+
+
+
+// -- class Basic_Format_Registry --------------
+// struct Shard: the number of Readers in each half of the epoch (see
+// raw_synchronize), aligned to a cache line of its own so that readers on
+// different shards don't contend
+template <typename T, typename U>
+struct alignas(64) Basic_Format_Registry<T,U>::Shard {
+  std::atomic<std::size_t>  readers[2];
+
+  Shard() {
+    readers[0].store(0);
+    readers[1].store(0);
+  }
+};
+
+template <typename T, typename U>
+auto Basic_Format_Registry<T,U>::Generation::format(const string& name) const
+    -> const format_type* {
+  const auto i = formats_.find(name);
+  return i == formats_.end() ? nullptr : &i->second;
+}
+
+template <typename T, typename U>
+auto Basic_Format_Registry<T,U>::Generation::translation(
+    const string& name) const -> const translation_type* {
+  const auto i = translations_.find(name);
+  return i == translations_.end() ? nullptr : &i->second;
+}
+
+template <typename T, typename U>
+auto Basic_Format_Registry<T,U>::Generation::number() const
+    -> generation_type {
+  return number_;
+}
+
+// Reader: announce the reader in its shard's counter for the current half
+// of the epoch *before* loading the generation. All the operations here and
+// in raw_synchronize are sequentially consistent, so either the writer sees
+// the count or the reader sees the writer's new generation.
+template <typename T, typename U>
+Basic_Format_Registry<T,U>::Reader::Reader(const Basic_Format_Registry& r)
+  : registry_   {&r},
+    shard_      {r.raw_shard()},
+    parity_     {r.epoch_.load() & 1},
+    generation_ {nullptr}
+{
+  registry_->shards_[shard_].readers[parity_].fetch_add(1);
+  generation_ = registry_->current_.load();
+}
+
+template <typename T, typename U>
+Basic_Format_Registry<T,U>::Reader::Reader(Reader&& r)
+  : registry_   {r.registry_},
+    shard_      {r.shard_},
+    parity_     {r.parity_},
+    generation_ {r.generation_}
+{
+  r.registry_ = nullptr;
+}
+
+template <typename T, typename U>
+Basic_Format_Registry<T,U>::Reader::~Reader() {
+  if (registry_)
+    registry_->shards_[shard_].readers[parity_].fetch_sub(1);
+}
+
+template <typename T, typename U>
+auto Basic_Format_Registry<T,U>::Reader::operator*() const
+    -> const Generation& {
+  return *generation_;
+}
+
+template <typename T, typename U>
+auto Basic_Format_Registry<T,U>::Reader::operator->() const
+    -> const Generation* {
+  return generation_;
+}
+
+// ctor: Basic_Format_Registry(const std::size_t)
+template <typename T, typename U>
+Basic_Format_Registry<T,U>::Basic_Format_Registry(const std::size_t shards)
+  : shard_count_ {shards ? shards : 1},
+    shard_block_ {new char[shard_count_ * sizeof(Shard) + alignof(Shard)]},
+    shards_      {nullptr},
+    current_     {new Generation()},
+    epoch_       {0}
+{
+  // (before C++17, new does not align beyond alignof(std::max_align_t),
+  // so the shards are placed in their block by hand)
+  void* block = shard_block_.get();
+  std::size_t space = shard_count_ * sizeof(Shard) + alignof(Shard);
+  shards_ = static_cast<Shard*>(std::align(alignof(Shard),
+                                           shard_count_ * sizeof(Shard),
+                                           block, space));
+  for (std::size_t i = 0; i < shard_count_; ++i)
+    new (shards_ + i) Shard();
+}
+
+// the registry must have no Readers left, so the current generation can
+// simply be freed
+template <typename T, typename U>
+Basic_Format_Registry<T,U>::~Basic_Format_Registry() {
+  delete current_.load();
+  for (std::size_t i = 0; i < shard_count_; ++i)
+    shards_[i].~Shard();
+}
+
+template <typename T, typename U>
+auto Basic_Format_Registry<T,U>::read() const -> Reader {
+  return Reader(*this);
+}
+
+template <typename T, typename U>
+auto Basic_Format_Registry<T,U>::publish(format_map formats,
+                                         translation_map translations)
+    -> generation_type {
+  std::lock_guard<std::mutex> lock(write_mutex_);
+  Generation* g = new Generation();
+  g->formats_ = std::move(formats);
+  g->translations_ = std::move(translations);
+  g->number_ = current_.load()->number_ + 1;
+  const Generation* old = current_.exchange(g);
+  raw_synchronize();
+  delete old;
+  return g->number_;
+}
+
+template <typename T, typename U>
+std::size_t Basic_Format_Registry<T,U>::raw_shard() const {
+  return std::hash<std::thread::id>()(std::this_thread::get_id())
+         % shard_count_;
+}
+
+// raw_synchronize: wait until no Reader can hold the generation that was
+// current before the last exchange. Readers count themselves in the half
+// of the epoch they saw when they started, so it is enough to flip the
+// epoch (new Readers then count in the other half) and wait for the old
+// half to drain. But a Reader that read the epoch before an earlier flip
+// and was held up before counting itself may still count in the *other*
+// half and pick up the old generation, so drain that half first (as SRCU
+// does). Neither wait can be starved by new Readers, which always count in
+// the current half.
+template <typename T, typename U>
+void Basic_Format_Registry<T,U>::raw_synchronize() {
+  const std::size_t epoch = epoch_.load();
+  raw_wait((epoch + 1) & 1);
+  epoch_.store(epoch + 1);
+  raw_wait(epoch & 1);
+}
+
+template <typename T, typename U>
+void Basic_Format_Registry<T,U>::raw_wait(const std::size_t parity) const {
+  for (std::size_t i = 0; i < shard_count_; ++i)
+    while (shards_[i].readers[parity].load() != 0)
+      std::this_thread::yield();
+}
+
+
+
+
+// -- class Basic_Catalog --------------
+// the layout of a block (see the class description). Every field is eight
+// bytes, or a multiple of them, so that the structs have no padding.
+template <typename T, typename U>
+struct Basic_Catalog<T,U>::Header {
+  char           magic[8];      // "ARITHMOS"
+  std::uint32_t  version;
+  std::uint32_t  byte_order;    // 0x01020304
+  std::uint32_t  char_size;
+  std::uint32_t  count_size;
+  std::uint32_t  digit_size;
+  std::uint32_t  reserved;
+  std::uint64_t  formats;
+  std::uint64_t  translations;
+  std::uint64_t  size;          // of the whole block
+  std::uint64_t  checksum;      // of the block after the header
+};
+
+// the offsets (from the start of the block) and lengths (in characters or
+// digits) of the parts of a format, and its symbols
+template <typename T, typename U>
+struct Basic_Catalog<T,U>::Format_Entry {
+  std::uint64_t  name;
+  std::uint64_t  name_length;
+  std::uint64_t  specifier;
+  std::uint64_t  specifier_length;
+  std::uint64_t  digits;
+  std::uint64_t  digits_size;
+  std::uint64_t  exp;
+  std::uint64_t  exp_length;
+  std::uint64_t  exp_digits;
+  std::uint64_t  exp_digits_size;
+  std::uint64_t  point;
+  std::uint64_t  plus;
+  std::uint64_t  minus;
+  std::uint64_t  separator;
+  std::uint64_t  group;
+};
+
+// the offsets of the name and characters of a translation: the character
+// at from[i] translates into the character at to[i]
+template <typename T, typename U>
+struct Basic_Catalog<T,U>::Translation_Entry {
+  std::uint64_t  name;
+  std::uint64_t  name_length;
+  std::uint64_t  from;
+  std::uint64_t  to;
+  std::uint64_t  size;
+};
+
+template <typename T, typename U>
+const std::uint32_t Basic_Catalog<T,U>::version;
+
+template <typename T, typename U>
+const typename Basic_Catalog<T,U>::size_type Basic_Catalog<T,U>::npos;
+
+// ctor: Basic_Catalog(const void*, const size_type)
+template <typename T, typename U>
+Basic_Catalog<T,U>::Basic_Catalog(const void* data, const size_type size)
+  : data_                {static_cast<const unsigned char*>(data)},
+    header_              {nullptr},
+    format_entries_      {nullptr},
+    translation_entries_ {nullptr},
+    formats_             {},
+    translations_        {},
+    mutex_               {}
+{
+  if ( validate(data, size) != errc::ok )
+    LIBARITHMOS_THROW(invalid_catalog());
+  header_ = reinterpret_cast<const Header*>(data_);
+  format_entries_ =
+      reinterpret_cast<const Format_Entry*>(data_ + sizeof(Header));
+  translation_entries_ = reinterpret_cast<const Translation_Entry*>(
+      format_entries_ + header_->formats);
+  formats_.reset(new std::atomic<const format_type*>[header_->formats]());
+  translations_.reset(
+      new std::atomic<const translation_type*>[header_->translations]());
+}
+
+template <typename T, typename U>
+Basic_Catalog<T,U>::~Basic_Catalog() {
+  for (size_type i = 0; i < formats(); ++i)
+    delete formats_[i].load();
+  for (size_type i = 0; i < translations(); ++i)
+    delete translations_[i].load();
+}
+
+// validate: check the header, then the checksum (so that a corrupted block
+// is caught before its entries are read), then that every entry lies within
+// the block, that the names and the characters translated are in order, and
+// that every format could be constructed. Nothing is copied.
+template <typename T, typename U>
+errc Basic_Catalog<T,U>::validate(const void* data,
+                                  const size_type size) noexcept {
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  if ( !bytes || size < sizeof(Header) || size % 8 != 0 ||
+       reinterpret_cast<std::uintptr_t>(bytes) % 8 != 0 )
+    return errc::catalog;
+  const Header& h = *reinterpret_cast<const Header*>(bytes);
+  if ( std::memcmp(h.magic, "ARITHMOS", 8) != 0 ||
+       h.version != version || h.byte_order != 0x01020304 ||
+       h.char_size != sizeof(char_type) ||
+       h.count_size != sizeof(count_type) ||
+       h.digit_size != sizeof(digit_type) || h.size != size ||
+       raw_checksum(bytes + sizeof(Header), bytes + size) != h.checksum )
+    return errc::catalog;
+
+  if ( !raw_span(size, sizeof(Header), h.formats, sizeof(Format_Entry)) )
+    return errc::catalog;
+  const std::uint64_t translations_offset =
+      sizeof(Header) + h.formats * sizeof(Format_Entry);
+  if ( !raw_span(size, translations_offset, h.translations,
+                 sizeof(Translation_Entry)) )
+    return errc::catalog;
+
+  // a character is stored widened to 64 bits, so it must narrow back to
+  // the same value
+  auto is_char = [](const std::uint64_t c) {
+    return static_cast<std::uint64_t>(static_cast<char_type>(c)) == c;
+  };
+  auto chars = [bytes](const std::uint64_t offset) {
+    return reinterpret_cast<const char_type*>(bytes + offset);
+  };
+
+  const Format_Entry* f =
+      reinterpret_cast<const Format_Entry*>(bytes + sizeof(Header));
+  for (std::uint64_t i = 0; i < h.formats; ++i) {
+    const Format_Entry& e = f[i];
+    if ( !raw_span(size, e.name, e.name_length, sizeof(char_type)) ||
+         !raw_span(size, e.specifier, e.specifier_length,
+                   sizeof(char_type)) ||
+         !raw_span(size, e.digits, e.digits_size, sizeof(digit_type)) ||
+         !raw_span(size, e.exp, e.exp_length, sizeof(char_type)) ||
+         !raw_span(size, e.exp_digits, e.exp_digits_size,
+                   sizeof(digit_type)) ||
+         !is_char(e.point) || !is_char(e.plus) || !is_char(e.minus) ||
+         !is_char(e.separator) ||
+         e.group > std::numeric_limits<std::size_t>::max() )
+      return errc::catalog;
+    if ( i > 0 && raw_compare(chars(f[i-1].name), f[i-1].name_length,
+                              chars(e.name), e.name_length) >= 0 )
+      return errc::catalog;
+    const typename format_type::Symbols symbols(
+        static_cast<char_type>(e.point), static_cast<char_type>(e.plus),
+        static_cast<char_type>(e.minus),
+        static_cast<char_type>(e.separator),
+        static_cast<std::size_t>(e.group));
+    if ( format_type::validate(
+           digits_view(reinterpret_cast<const digit_type*>(bytes + e.digits),
+                       e.digits_size),
+           digits_view(
+             reinterpret_cast<const digit_type*>(bytes + e.exp_digits),
+             e.exp_digits_size),
+           symbols) != errc::ok )
+      return errc::catalog;
+  }
+
+  const Translation_Entry* t =
+      reinterpret_cast<const Translation_Entry*>(bytes + translations_offset);
+  for (std::uint64_t i = 0; i < h.translations; ++i) {
+    const Translation_Entry& e = t[i];
+    if ( !raw_span(size, e.name, e.name_length, sizeof(char_type)) ||
+         !raw_span(size, e.from, e.size, sizeof(char_type)) ||
+         !raw_span(size, e.to, e.size, sizeof(char_type)) )
+      return errc::catalog;
+    if ( i > 0 && raw_compare(chars(t[i-1].name), t[i-1].name_length,
+                              chars(e.name), e.name_length) >= 0 )
+      return errc::catalog;
+    const char_type* from = chars(e.from);
+    for (std::uint64_t j = 1; j < e.size; ++j)
+      if ( !std::char_traits<char_type>::lt(from[j-1], from[j]) )
+        return errc::catalog;
+  }
+  return errc::ok;
+}
+
+// compile: lay the block out (the header, the entries and then the data,
+// each part aligned to eight bytes) and then fill it in. The block starts
+// zeroed, so the padding between the parts is too, and the same formats
+// always compile to the same bytes.
+template <typename T, typename U>
+std::string Basic_Catalog<T,U>::compile(const format_map& formats,
+                                        const translation_map& translations) {
+  typedef typename format_map::value_type       format_value;
+  typedef typename translation_map::value_type  translation_value;
+  typedef std::pair<char_type,char_type>        pair;
+  auto by_from = [](const pair& a, const pair& b) {
+    return std::char_traits<char_type>::lt(a.first, b.first);
+  };
+
+  std::vector<const format_value*> f;
+  for (auto i = formats.begin(); i != formats.end(); ++i)
+    f.push_back(&*i);
+  std::sort(f.begin(), f.end(),
+            [](const format_value* a, const format_value* b) {
+              return a->first < b->first;
+            });
+  std::vector<const translation_value*> t;
+  for (auto i = translations.begin(); i != translations.end(); ++i)
+    t.push_back(&*i);
+  std::sort(t.begin(), t.end(),
+            [](const translation_value* a, const translation_value* b) {
+              return a->first < b->first;
+            });
+
+  // each translation as its characters and what they translate into,
+  // sorted (a character in more than one congruence keeps the first)
+  std::vector<std::vector<pair>> pairs(t.size());
+  for (std::size_t i = 0; i < t.size(); ++i) {
+    for (auto c = t[i]->second.begin(); c != t[i]->second.end(); ++c)
+      for (auto e = c->get_set().begin(); e != c->get_set().end(); ++e)
+        pairs[i].push_back(pair(*e, c->get_default()));
+    std::stable_sort(pairs[i].begin(), pairs[i].end(), by_from);
+    pairs[i].erase(std::unique(pairs[i].begin(), pairs[i].end(),
+                               [](const pair& a, const pair& b) {
+                                 return a.first == b.first;
+                               }),
+                   pairs[i].end());
+  }
+
+  std::uint64_t size = sizeof(Header) + f.size() * sizeof(Format_Entry)
+                       + t.size() * sizeof(Translation_Entry);
+  auto place = [&size](const std::uint64_t bytes) {
+    const std::uint64_t offset = size;
+    size += (bytes + 7) / 8 * 8;
+    return offset;
+  };
+  std::vector<Format_Entry> fe(f.size());
+  for (std::size_t i = 0; i < f.size(); ++i) {
+    const format_type& format = f[i]->second;
+    Format_Entry& e = fe[i];
+    e.name_length = f[i]->first.length();
+    e.name = place(e.name_length * sizeof(char_type));
+    e.specifier_length = format.specifier().length();
+    e.specifier = place(e.specifier_length * sizeof(char_type));
+    // (the point, which the format pushes onto its digits, is left off)
+    e.digits_size = format.digits().size() - 1;
+    e.digits = place(e.digits_size * sizeof(digit_type));
+    e.exp_length = format.exponent_specifier().length();
+    e.exp = place(e.exp_length * sizeof(char_type));
+    e.exp_digits_size = format.exponent_digits().size();
+    e.exp_digits = place(e.exp_digits_size * sizeof(digit_type));
+    e.point = static_cast<std::uint64_t>(format.symbols().point);
+    e.plus = static_cast<std::uint64_t>(format.symbols().plus);
+    e.minus = static_cast<std::uint64_t>(format.symbols().minus);
+    e.separator = static_cast<std::uint64_t>(format.symbols().separator);
+    e.group = format.symbols().group;
+  }
+  std::vector<Translation_Entry> te(t.size());
+  for (std::size_t i = 0; i < t.size(); ++i) {
+    Translation_Entry& e = te[i];
+    e.name_length = t[i]->first.length();
+    e.name = place(e.name_length * sizeof(char_type));
+    e.size = pairs[i].size();
+    e.from = place(e.size * sizeof(char_type));
+    e.to = place(e.size * sizeof(char_type));
+  }
+
+  std::string block(size, '\0');
+  unsigned char* bytes = reinterpret_cast<unsigned char*>(&block[0]);
+  auto put = [bytes](const std::uint64_t offset, const char_type* chars,
+                     const std::uint64_t length) {
+    std::memcpy(bytes + offset, chars, length * sizeof(char_type));
+  };
+  auto put_digits = [bytes](const std::uint64_t offset,
+                            const digit_type* digits,
+                            const std::uint64_t count) {
+    for (std::uint64_t i = 0; i < count; ++i)
+      new (bytes + offset + i * sizeof(digit_type)) digit_type(digits[i]);
+  };
+  for (std::size_t i = 0; i < f.size(); ++i) {
+    const format_type& format = f[i]->second;
+    const Format_Entry& e = fe[i];
+    put(e.name, f[i]->first.data(), e.name_length);
+    put(e.specifier, format.specifier().data(), e.specifier_length);
+    put_digits(e.digits, format.digits().data(), e.digits_size);
+    put(e.exp, format.exponent_specifier().data(), e.exp_length);
+    put_digits(e.exp_digits, format.exponent_digits().data(),
+               e.exp_digits_size);
+  }
+  for (std::size_t i = 0; i < t.size(); ++i) {
+    const Translation_Entry& e = te[i];
+    put(e.name, t[i]->first.data(), e.name_length);
+    for (std::size_t j = 0; j < pairs[i].size(); ++j) {
+      put(e.from + j * sizeof(char_type), &pairs[i][j].first, 1);
+      put(e.to + j * sizeof(char_type), &pairs[i][j].second, 1);
+    }
+  }
+  if (!fe.empty())
+    std::memcpy(bytes + sizeof(Header), fe.data(),
+                fe.size() * sizeof(Format_Entry));
+  if (!te.empty())
+    std::memcpy(bytes + sizeof(Header) + fe.size() * sizeof(Format_Entry),
+                te.data(), te.size() * sizeof(Translation_Entry));
+
+  Header h;
+  std::memset(&h, 0, sizeof(h));
+  std::memcpy(h.magic, "ARITHMOS", 8);
+  h.version = version;
+  h.byte_order = 0x01020304;
+  h.char_size = sizeof(char_type);
+  h.count_size = sizeof(count_type);
+  h.digit_size = sizeof(digit_type);
+  h.formats = f.size();
+  h.translations = t.size();
+  h.size = size;
+  h.checksum = raw_checksum(bytes + sizeof(Header), bytes + size);
+  std::memcpy(bytes, &h, sizeof(h));
+  return block;
+}
+
+template <typename T, typename U>
+auto Basic_Catalog<T,U>::formats() const -> size_type {
+  return header_->formats;
+}
+
+template <typename T, typename U>
+auto Basic_Catalog<T,U>::translations() const -> size_type {
+  return header_->translations;
+}
+
+template <typename T, typename U>
+auto Basic_Catalog<T,U>::format_name(const size_type i) const -> string {
+  return string(raw_chars(format_entries_[i].name),
+                format_entries_[i].name_length);
+}
+
+template <typename T, typename U>
+auto Basic_Catalog<T,U>::translation_name(const size_type i) const
+    -> string {
+  return string(raw_chars(translation_entries_[i].name),
+                translation_entries_[i].name_length);
+}
+
+template <typename T, typename U>
+auto Basic_Catalog<T,U>::find_format(const string& name) const
+    -> size_type {
+  return raw_find(format_entries_, formats(), name);
+}
+
+template <typename T, typename U>
+auto Basic_Catalog<T,U>::find_translation(const string& name) const
+    -> size_type {
+  return raw_find(translation_entries_, translations(), name);
+}
+
+template <typename T, typename U>
+auto Basic_Catalog<T,U>::digits(const size_type i) const -> digits_view {
+  return digits_view(
+      reinterpret_cast<const digit_type*>(data_ + format_entries_[i].digits),
+      format_entries_[i].digits_size);
+}
+
+template <typename T, typename U>
+auto Basic_Catalog<T,U>::exponent_digits(const size_type i) const
+    -> digits_view {
+  return digits_view(reinterpret_cast<const digit_type*>(
+                         data_ + format_entries_[i].exp_digits),
+                     format_entries_[i].exp_digits_size);
+}
+
+// format: the Basic_Format, built on first use
+template <typename T, typename U>
+auto Basic_Catalog<T,U>::format(const size_type i) const
+    -> const format_type& {
+  const format_type* f = formats_[i].load(std::memory_order_acquire);
+  if (f)
+    return *f;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  f = formats_[i].load(std::memory_order_relaxed);
+  if (!f) {
+    const Format_Entry& e = format_entries_[i];
+    f = new format_type{ string(raw_chars(e.specifier), e.specifier_length),
+                         digits(i),
+                         string(raw_chars(e.exp), e.exp_length),
+                         exponent_digits(i),
+                         typename format_type::Symbols(
+                           static_cast<char_type>(e.point),
+                           static_cast<char_type>(e.plus),
+                           static_cast<char_type>(e.minus),
+                           static_cast<char_type>(e.separator),
+                           static_cast<std::size_t>(e.group)) };
+    formats_[i].store(f, std::memory_order_release);
+  }
+  return *f;
+}
+
+template <typename T, typename U>
+auto Basic_Catalog<T,U>::format(const string& name) const
+    -> const format_type* {
+  const size_type i = find_format(name);
+  return i == npos ? nullptr : &format(i);
+}
+
+// translation: the set of congruences, built on first use (as
+// Basic_Predefined_Translation::get builds it)
+template <typename T, typename U>
+auto Basic_Catalog<T,U>::translation(const size_type i) const
+    -> const translation_type& {
+  const translation_type* t =
+      translations_[i].load(std::memory_order_acquire);
+  if (t)
+    return *t;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  t = translations_[i].load(std::memory_order_relaxed);
+  if (!t) {
+    const Translation_Entry& e = translation_entries_[i];
+    const char_type* from = raw_chars(e.from);
+    const char_type* to = raw_chars(e.to);
+    translation_type* built = new translation_type{};
+    for (std::uint64_t j = 0; j < e.size; ++j) {
+      typename Basic_Congruence<T>::set set{ to[j] };
+      for (std::uint64_t k = 0; k < e.size; ++k)
+        if (to[k] == to[j])
+          set.insert(from[k]);
+      built->insert(Basic_Congruence<T>{ set, to[j] });
+    }
+    t = built;
+    translations_[i].store(t, std::memory_order_release);
+  }
+  return *t;
+}
+
+template <typename T, typename U>
+auto Basic_Catalog<T,U>::translation(const string& name) const
+    -> const translation_type* {
+  const size_type i = find_translation(name);
+  return i == npos ? nullptr : &translation(i);
+}
+
+// translate: the characters translated are sorted, so each character of
+// the input is looked up with a binary search
+template <typename T, typename U>
+auto Basic_Catalog<T,U>::translate(const size_type i,
+                                   const string& input) const -> string {
+  const Translation_Entry& e = translation_entries_[i];
+  const char_type* from = raw_chars(e.from);
+  const char_type* from_end = from + e.size;
+  const char_type* to = raw_chars(e.to);
+  string output;
+  output.reserve(input.size());
+  for (auto c : input) {
+    const char_type* j = std::lower_bound(from, from_end, c,
+                                          std::char_traits<char_type>::lt);
+    output += (j != from_end && *j == c) ? to[j - from] : c;
+  }
+  return output;
+}
+
+template <typename T, typename U>
+template <typename TEntry>
+auto Basic_Catalog<T,U>::raw_find(const TEntry* entries,
+                                  const size_type count,
+                                  const string& name) const -> size_type {
+  size_type first = 0;
+  size_type last = count;
+  while (first < last) {
+    const size_type middle = first + (last - first) / 2;
+    const int c = raw_compare(raw_chars(entries[middle].name),
+                              entries[middle].name_length,
+                              name.data(), name.length());
+    if (c == 0)
+      return middle;
+    if (c < 0)
+      first = middle + 1;
+    else
+      last = middle;
+  }
+  return npos;
+}
+
+template <typename T, typename U>
+auto Basic_Catalog<T,U>::raw_chars(const std::uint64_t offset) const
+    -> const char_type* {
+  return reinterpret_cast<const char_type*>(data_ + offset);
+}
+
+template <typename T, typename U>
+bool Basic_Catalog<T,U>::raw_span(const size_type size,
+                                  const std::uint64_t offset,
+                                  const std::uint64_t count,
+                                  const std::uint64_t unit) noexcept {
+  return offset % 8 == 0 && offset <= size &&
+         count <= (size - offset) / unit;
+}
+
+template <typename T, typename U>
+int Basic_Catalog<T,U>::raw_compare(const char_type* a,
+                                    const std::uint64_t a_length,
+                                    const char_type* b,
+                                    const std::uint64_t b_length) noexcept {
+  const int c = std::char_traits<char_type>::compare(
+                    a, b, static_cast<std::size_t>(std::min(a_length,
+                                                            b_length)));
+  if (c != 0)
+    return c;
+  return a_length < b_length ? -1 : (a_length > b_length ? 1 : 0);
+}
+
+// raw_checksum: FNV-1a, taking the bytes eight at a time (a block is a
+// multiple of eight bytes long) to be eight times quicker. Each step is a
+// bijection of the word, so corrupting any one word always changes the
+// checksum.
+template <typename T, typename U>
+std::uint64_t Basic_Catalog<T,U>::raw_checksum(
+    const unsigned char* first, const unsigned char* last) noexcept {
+  std::uint64_t hash = 14695981039346656037ull;
+  for (; first != last; first += 8) {
+    std::uint64_t word;
+    std::memcpy(&word, first, 8);
+    hash ^= word;
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+
+
+
+// -- class Basic_Push_Parser --------------
+// ctor: Basic_Push_Parser(const format_type&)
+template <typename T, typename U>
+Basic_Push_Parser<T,U>::Basic_Push_Parser(const format_type& format)
+  : format_            (format),
+    whole_             (format.digits()),
+    exponent_          (format.exponent_digits()),
+    input_             {},
+    state_             {Parse_State::viable},
+    part_              {Part::sign},
+    specifier_matched_ {0},
+    digits_            {0},
+    point_only_        {false},
+    decimal_           {false},
+    groups_            (format.symbols().group),
+    pending_           {0},
+    exponent_digits_   {0}
+{}
+
+template <typename T, typename U>
+Parse_State Basic_Push_Parser<T,U>::feed(const char_type c) {
+  if (state_ != Parse_State::invalid)
+    state_ = raw_feed(c);
+  return state_;
+}
+
+template <typename T, typename U>
+Parse_State Basic_Push_Parser<T,U>::feed(const string& input) {
+  return feed(input.data(), input.data() + input.length());
+}
+
+template <typename T, typename U>
+Parse_State Basic_Push_Parser<T,U>::feed(const char_type* first,
+                                         const char_type* last) {
+  for (; first != last && state_ != Parse_State::invalid; ++first)
+    state_ = raw_feed(*first);
+  return state_;
+}
+
+template <typename T, typename U>
+Parse_State Basic_Push_Parser<T,U>::state() const {
+  return state_;
+}
+
+template <typename T, typename U>
+auto Basic_Push_Parser<T,U>::input() const -> const string& {
+  return input_;
+}
+
+template <typename T, typename U>
+auto Basic_Push_Parser<T,U>::finish() const -> data_type {
+  if (state_ == Parse_State::invalid)
+    return data_type();
+  return format_.compare(input_);
+}
+
+template <typename T, typename U>
+void Basic_Push_Parser<T,U>::reset() {
+  whole_.reset();
+  exponent_.reset();
+  input_.clear();
+  state_ = Parse_State::viable;
+  part_ = Part::sign;
+  specifier_matched_ = 0;
+  digits_ = 0;
+  point_only_ = false;
+  decimal_ = false;
+  groups_ = groups_type(format_.symbols().group);
+  pending_ = 0;
+  exponent_digits_ = 0;
+}
+
+// raw_feed: examine the next character, following compare. The first
+// character may be a sign; then the specifier must match; then come the
+// digits, up to the first occurrence of the exponent string; and then the
+// exponent's sign and digits. Parts that are empty in the format (no
+// specifier, or no exponent string) are skipped over.
+template <typename T, typename U>
+Parse_State Basic_Push_Parser<T,U>::raw_feed(const char_type c) {
+  input_ += c;
+  const string& specifier = format_.specifier();
+  if (part_ == Part::sign) {
+    part_ = Part::specifier;
+    if (specifier.empty())
+      part_ = Part::digits;
+    if (part_ == Part::digits && format_.exponent_specifier().empty())
+      part_ = Part::exponent_sign;
+    if (c == format_.symbols().plus || c == format_.symbols().minus)
+      return raw_state();
+  }
+
+  switch (part_) {
+  case Part::specifier:
+    if (specifier[specifier_matched_++] != c)
+      return Parse_State::invalid;
+    if (specifier_matched_ == specifier.length())
+      part_ = format_.exponent_specifier().empty() ? Part::exponent_sign
+                                                   : Part::digits;
+    break;
+  case Part::digits:
+    if (!raw_digit(c))
+      return Parse_State::invalid;
+    break;
+  case Part::exponent_sign:
+    part_ = Part::exponent_digits;
+    if (c == format_.symbols().plus || c == format_.symbols().minus)
+      break;
+    // fall through
+  case Part::exponent_digits: {
+    const std::size_t d = exponent_.find(c);
+    if (d == lookup_type::npos || !exponent_.count(d))
+      return Parse_State::invalid;
+    ++exponent_digits_;
+    break;
+  }
+  default:
+    break;
+  }
+  return raw_state();
+}
+
+// raw_digit: the character may be a digit or the start (or more) of the
+// exponent string, which compare finds by searching for its first
+// occurrence; so hold back the trailing characters that could begin the
+// exponent string (the `pending' characters) and only count them as digits
+// once they can no longer be part of it. Digit-group separators are
+// checked as compare checks them, except that a group grown too long is
+// caught at once. Return false if the input can no longer be a number.
+template <typename T, typename U>
+bool Basic_Push_Parser<T,U>::raw_digit(const char_type) {
+  const string& exp = format_.exponent_specifier();
+  const auto& symbols = format_.symbols();
+  ++pending_;
+  while (pending_ > 0 &&
+         input_.compare(input_.length() - pending_, pending_,
+                        exp, 0, pending_) != 0) {
+    const char_type d = input_[input_.length() - pending_];
+    --pending_;
+    if (symbols.separator != char_type(0) && d == symbols.separator) {
+      if (decimal_ || !groups_.separator())
+        return false;
+      continue;
+    }
+    const std::size_t i = whole_.find(d);
+    if (i == lookup_type::npos || !whole_.count(i))
+      return false;
+    point_only_ = digits_ == 0 && d == symbols.point;
+    ++digits_;
+    if (d == symbols.point) {
+      if (!groups_.end())
+        return false;
+      decimal_ = true;
+    }
+    else if (!decimal_) {
+      groups_.digit();
+      if (groups_.separated_ && groups_.width_ != 0 &&
+          groups_.count_ > groups_.width_)
+        return false;
+    }
+  }
+  if (pending_ == exp.length()) {
+    // a lone decimal point is not a number, even with an exponent; nor is
+    // a whole part whose last group is incomplete
+    if (point_only_ || (!decimal_ && !groups_.end()))
+      return false;
+    pending_ = 0;
+    part_ = Part::exponent_sign;
+  }
+  else if (pending_ > 0 && !raw_viable())
+    return false;
+  return true;
+}
+
+// raw_pending_digits: are the pending characters all digits (within their
+// counts) or well-placed separators, and would the whole part be complete
+// if it ended after them
+template <typename T, typename U>
+bool Basic_Push_Parser<T,U>::raw_pending_digits() const {
+  const auto& symbols = format_.symbols();
+  const std::size_t first = input_.length() - pending_;
+  groups_type groups = groups_;
+  bool decimal = decimal_;
+  for (std::size_t k = first; k < input_.length(); ++k) {
+    if ( symbols.separator != char_type(0) &&
+         input_[k] == symbols.separator ) {
+      if (decimal || !groups.separator())
+        return false;
+      continue;
+    }
+    const std::size_t i = whole_.find(input_[k]);
+    if (i == lookup_type::npos)
+      return false;
+    if (whole_.limited_) {
+      count_type n = whole_.count_list_[i] + 1;
+      for (std::size_t j = first; j < k; ++j)
+        if (input_[j] == input_[k])
+          ++n;
+      if (n > format_.digits()[i].count_max())
+        return false;
+    }
+    if (input_[k] == symbols.point) {
+      if (!groups.end())
+        return false;
+      decimal = true;
+    }
+    else if (!decimal)
+      groups.digit();
+  }
+  return decimal || groups.end();
+}
+
+// raw_viable: can the pending characters still be followed to a number:
+// some of them (perhaps none) must be taken as digits or separators, and
+// the rest begin the exponent string after a whole part that may end there
+// (not a lone point, nor an incomplete group). Taking them all as digits
+// leaves the input viable.
+template <typename T, typename U>
+bool Basic_Push_Parser<T,U>::raw_viable() const {
+  const auto& symbols = format_.symbols();
+  const string& exp = format_.exponent_specifier();
+  const std::size_t first = input_.length() - pending_;
+  groups_type groups = groups_;
+  bool decimal = decimal_;
+  bool point_only = point_only_;
+  for (std::size_t k = first; k < input_.length(); ++k) {
+    if ( !point_only && (decimal || groups.end()) &&
+         input_.compare(k, input_.length() - k,
+                        exp, 0, input_.length() - k) == 0 )
+      return true;
+    const char_type d = input_[k];
+    if (symbols.separator != char_type(0) && d == symbols.separator) {
+      if (decimal || !groups.separator())
+        return false;
+      continue;
+    }
+    const std::size_t i = whole_.find(d);
+    if (i == lookup_type::npos)
+      return false;
+    if (whole_.limited_) {
+      count_type n = whole_.count_list_[i] + 1;
+      for (std::size_t j = first; j < k; ++j)
+        if (input_[j] == d)
+          ++n;
+      if (n > format_.digits()[i].count_max())
+        return false;
+    }
+    point_only = digits_ + (k - first) == 0 && d == symbols.point;
+    if (d == symbols.point) {
+      if (!groups.end())
+        return false;
+      decimal = true;
+    }
+    else if (!decimal) {
+      groups.digit();
+      if (groups.separated_ && groups.width_ != 0 &&
+          groups.count_ > groups.width_)
+        return false;
+    }
+  }
+  return true;
+}
+
+// raw_state: the state of an input that is still viable (that is, return
+// whether it is complete)
+template <typename T, typename U>
+Parse_State Basic_Push_Parser<T,U>::raw_state() const {
+  switch (part_) {
+  case Part::digits: {
+    // the pending characters are digits after all if the input ends here
+    const std::size_t n = digits_ + pending_;
+    if (n == 0 || !raw_pending_digits())
+      return Parse_State::viable;
+    if ( n == 1 && (point_only_ ||
+                    input_.back() == format_.symbols().point) )
+      return Parse_State::viable;
+    return Parse_State::complete;
+  }
+  case Part::exponent_digits:
+    return exponent_digits_ ? Parse_State::complete : Parse_State::viable;
+  default:
+    return Parse_State::viable;
+  }
 }
 
 
@@ -0,0 +1,375 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                                                                         *
+ *  file: alloc.cpp                                                        *
+ *                                                                         *
+ *  This file is a part of the libarithmos package.                        *
+ *                                                                         *
+ *  Copyright (c) 2020, Karta Kooner GNU GPL v3+                           *
+ *                                                                         *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+// The global operator new and delete are replaced here by ones that count
+// the allocations made while a call is being measured, so that the number
+// of heap allocations each of the library's parse and convert entry points
+// makes can be reported, and the paths that are documented not to allocate
+// can be checked. (The library itself never calls malloc: everything it
+// allocates, it allocates through operator new, and so through these.)
+// The sized and aligned forms are replaced too, where the compiler has
+// them, so that no allocation goes uncounted.
+//
+// Each call is made once before it is measured, so that what is built on
+// first use (the pre-defined formats) and the capacity of the buffers that
+// are reused is not counted: the count is that of the steady state.
+
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <arithmos.h>
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+
+namespace {
+
+std::atomic<bool>           counting{false};
+std::atomic<unsigned long>  allocations{0};
+
+void* allocate(std::size_t size) {
+  if (counting.load(std::memory_order_relaxed))
+    allocations.fetch_add(1, std::memory_order_relaxed);
+  return std::malloc(size ? size : 1);
+}
+
+#ifdef __cpp_aligned_new
+// (aligned_alloc takes a size that is a multiple of the alignment)
+void* allocate(std::size_t size, std::align_val_t alignment) {
+  if (counting.load(std::memory_order_relaxed))
+    allocations.fetch_add(1, std::memory_order_relaxed);
+  const std::size_t a = static_cast<std::size_t>(alignment);
+  return std::aligned_alloc(a, size ? (size + a - 1) / a * a : a);
+}
+#endif
+
+} // anonymous namespace
+
+void* operator new(std::size_t size) {
+  void* p = allocate(size);
+  if (!p)
+    LIBARITHMOS_THROW(std::bad_alloc());
+  return p;
+}
+
+void* operator new[](std::size_t size) {
+  return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  return allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+  return allocate(size);
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+  std::free(p);
+}
+
+#ifdef __cpp_sized_deallocation
+void operator delete(void* p, std::size_t) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+  std::free(p);
+}
+#endif
+
+#ifdef __cpp_aligned_new
+void* operator new(std::size_t size, std::align_val_t alignment) {
+  void* p = allocate(size, alignment);
+  if (!p)
+    LIBARITHMOS_THROW(std::bad_alloc());
+  return p;
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+  return operator new(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment,
+                   const std::nothrow_t&) noexcept {
+  return allocate(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment,
+                     const std::nothrow_t&) noexcept {
+  return allocate(size, alignment);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t,
+                     const std::nothrow_t&) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void* p, std::align_val_t,
+                       const std::nothrow_t&) noexcept {
+  std::free(p);
+}
+#endif
+
+
+// the allocations made by a call, after it has been made once
+template <typename F>
+unsigned long count(F f) {
+  f();
+  allocations = 0;
+  counting = true;
+  f();
+  counting = false;
+  return allocations;
+}
+
+
+// a number of the format: -10.1e1 (in the format's own digits), and the
+// integer literal -101
+template <typename T, typename U>
+std::basic_string<T> sample(const Arithmos::Basic_Format<T,U>& f,
+                            const bool integer) {
+  const auto& d = f.digits();
+  const auto& e = f.exponent_digits();
+  std::basic_string<T> s(1, f.symbols().minus);
+  s += f.specifier();
+  s += d[1].name();
+  s += d[0].name();
+  if (!integer) {
+    s += f.symbols().point;
+    s += d[1].name();
+    s += f.exponent_specifier();
+    s += e[1].name();
+  }
+  else
+    s += d[1].name();
+  return s;
+}
+
+
+// an integer literal of the format longer than 64 bits, for the paths that
+// go through the library's arbitrary-precision integers: 70 digits, 1010...
+template <typename T, typename U>
+std::basic_string<T> long_sample(const Arithmos::Basic_Format<T,U>& f) {
+  const auto& d = f.digits();
+  std::basic_string<T> s = f.specifier();
+  for (int i = 0; i < 70; ++i)
+    s += d[(i + 1) % 2].name();
+  return s;
+}
+
+
+// the paths measured: their names, and whether they are documented not to
+// allocate (the check fails if one of those does)
+struct Path {
+  const char*  name;
+  bool         allocation_free;
+};
+
+const Path paths[] = {
+  { "get",              true },  // Basic_Predefined_Format::get, once built
+  { "validate",         true },  // Basic_Format::validate
+  { "push",             true },  // Basic_Push_Parser::feed, after a reset
+  { "compare_into",     true },  // Basic_Format::compare_into, with a context
+  { "to_into",          true },  // Basic_Format::to_into, with a context
+  { "add_into",         true },  // Basic_Format::add_into, with a context
+  { "compare_into_long", true }, // compare_into, over 64 bits
+  { "add_into_long",    true },  // add_into, over 64 bits
+  { "to_into_long",     false }, // to_into, over 64 bits (see Context)
+  { "compare",          false },
+  { "parse",            false },
+  { "to",               false },
+  { "convert",          false },
+  { "order",            false },
+  { "hash",             false },
+  { "sort_key",         false }
+};
+
+
+// measure every path for one of the pre-defined formats, printing the
+// counts (when reporting) or the failures (when checking). Return false if
+// a path that should not allocate does.
+template <typename T, typename U>
+bool measure(const Arithmos::Basic_Predefined_Format<T,U>& predefined,
+             const char* format_name, const char* type_name,
+             const bool report) {
+  typedef Arithmos::Basic_Format<T,U>  format_type;
+  typedef std::basic_string<T>         string;
+
+  const format_type& f = predefined.get();
+  const string number = sample(f, false);
+  const string integer = sample(f, true);
+  const string long_integer = long_sample(f);
+  Arithmos::Basic_Data<T> data;
+  Arithmos::Basic_Data<T> other = f.compare(integer);
+  Arithmos::Basic_Push_Parser<T,U> parser(f);
+  typename format_type::Context context;
+  string output;
+  output.reserve(64);
+
+  unsigned long counts[sizeof(paths) / sizeof(paths[0])] = {
+    count([&] { predefined.get(); }),
+    count([&] { format_type::validate(f.digits(), f.exponent_digits(),
+                                      f.symbols()); }),
+    count([&] { parser.reset(); parser.feed(number); }),
+    count([&] { f.compare_into(number, data, context); }),
+    count([&] { f.to_into(f, integer, output, context); }),
+    count([&] { f.add_into(number, integer, output, context); }),
+    count([&] { f.compare_into(long_integer, data, context); }),
+    count([&] { f.add_into(long_integer, integer, output, context); }),
+    count([&] { f.to_into(f, long_integer, output, context); }),
+    count([&] { f.compare(number); }),
+    count([&] { f.parse(number, data); }),
+    count([&] { f.to(f, integer); }),
+    count([&] { output.clear(); f.convert(f, integer, output); }),
+    count([&] { f.order(data, other); }),
+    count([&] { f.hash(data); }),
+    count([&] { f.sort_key(data); })
+  };
+
+  bool ok = true;
+  for (std::size_t i = 0; i < sizeof(paths) / sizeof(paths[0]); ++i) {
+    if (report)
+      std::cout << format_name << ' ' << type_name << ' ' << paths[i].name
+                << ' ' << counts[i] << '\n';
+    if (paths[i].allocation_free && counts[i] != 0) {
+      std::cerr << "failure: " << format_name << ' ' << type_name << ' '
+                << paths[i].name << " made " << counts[i]
+                << " allocations.\n";
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+template <typename T, typename U>
+bool measure_all(const Arithmos::Basic_Predefined_Format<T,U>& binary,
+                 const Arithmos::Basic_Predefined_Format<T,U>& octal,
+                 const Arithmos::Basic_Predefined_Format<T,U>& decimal,
+                 const Arithmos::Basic_Predefined_Format<T,U>& hexadecimal,
+                 const char* type_name, const bool report) {
+  bool ok = measure(binary, "binary", type_name, report);
+  ok = measure(octal, "octal", type_name, report) && ok;
+  ok = measure(decimal, "decimal", type_name, report) && ok;
+  ok = measure(hexadecimal, "hexadecimal", type_name, report) && ok;
+  return ok;
+}
+
+
+int main(int argc, char* argv[]) {
+  // alloc report <type>:  print the allocations each path makes with each
+  //                       pre-defined format of the character type
+  // alloc check <type>:   print nothing, but fail if a path documented not
+  //                       to allocate does
+  // alloc has <type>:     print nothing, but fail if the character type is
+  //                       not supported (char8_t needs C++20)
+  if (argc < 3) {
+    std::cerr << "failure: program usage incorrect.";
+    return 1;
+  }
+  const std::string mode(argv[1]);
+  const std::string type(argv[2]);
+  if (mode == "has") {
+#ifdef __cpp_char8_t
+    if (type == "char8_t")
+      return 0;
+#endif
+    return type == "char" || type == "wchar_t" || type == "char16_t" ||
+           type == "char32_t" ? 0 : 1;
+  }
+  if (mode != "report" && mode != "check") {
+    std::cerr << "failure: mode (" << mode << ") not recognized.";
+    return 1;
+  }
+  const bool report = mode == "report";
+
+  // the counts mean nothing if the replacement operator new is not the one
+  // in use
+  static std::string sink;
+  if (count([] { sink.assign(100, 'x'); sink.clear(); sink.shrink_to_fit(); })
+        == 0) {
+    std::cerr << "failure: allocations are not being counted.";
+    return 1;
+  }
+
+  bool ok;
+  if (type == "char")
+    ok = measure_all(Arithmos::binary, Arithmos::octal, Arithmos::decimal,
+                     Arithmos::hexadecimal, "char", report);
+  else if (type == "wchar_t")
+    ok = measure_all(Arithmos::wbinary, Arithmos::woctal,
+                     Arithmos::wdecimal, Arithmos::whexadecimal,
+                     "wchar_t", report);
+#ifdef __cpp_char8_t
+  else if (type == "char8_t")
+    ok = measure_all(Arithmos::u8binary, Arithmos::u8octal,
+                     Arithmos::u8decimal, Arithmos::u8hexadecimal,
+                     "char8_t", report);
+#endif
+  else if (type == "char16_t")
+    ok = measure_all(Arithmos::u16binary, Arithmos::u16octal,
+                     Arithmos::u16decimal, Arithmos::u16hexadecimal,
+                     "char16_t", report);
+  else if (type == "char32_t")
+    ok = measure_all(Arithmos::u32binary, Arithmos::u32octal,
+                     Arithmos::u32decimal, Arithmos::u32hexadecimal,
+                     "char32_t", report);
+  else {
+    std::cerr << "failure: character type (" << type << ") not recognized.";
+    return 1;
+  }
+  return ok ? 0 : 1;
+}
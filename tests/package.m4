@@ -4,9 +4,9 @@ m4_define([AT_PACKAGE_NAME],
 m4_define([AT_PACKAGE_TARNAME],
   [libarithmos])
 m4_define([AT_PACKAGE_VERSION],
-  [1.0.0])
+  [2.0.0])
 m4_define([AT_PACKAGE_STRING],
-  [libarithmos 1.0.0])
+  [libarithmos 2.0.0])
 m4_define([AT_PACKAGE_BUGREPORT],
   [ksa.kooner@gmail.com])
 m4_define([AT_PACKAGE_URL],
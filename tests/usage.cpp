@@ -23,6 +23,9 @@
 
 
 #include <iostream>
+#include <fstream>
+#include <thread>
+#include <regex>
 #include <arithmos.h>
 #ifdef HAVE_CONFIG_H
 #  include "config.h"
@@ -48,8 +51,183 @@ void print_data(const Arithmos::Data& d) {
 }
 
 
+// the pre-defined formats are constant-initialized, so they can be used in
+// the initialization of other global objects, whatever the order of their
+// initialization
+const std::string static_init_check =
+          Arithmos::hexadecimal.to(Arithmos::decimal, "0xff") + ':' +
+          Arithmos::translate<>(std::string("0xabCD"),
+                                Arithmos::hex_lower_to_upper);
+
+
+// widen a narrow (ASCII) string into a string of another character type,
+// and narrow it back again for printing.
+template <typename T>
+std::basic_string<T> widen(const std::string& s) {
+  return std::basic_string<T>(s.begin(), s.end());
+}
+
+template <typename T>
+std::string narrow(const std::basic_string<T>& s) {
+  std::string ret;
+  for (auto c : s)
+    ret += static_cast<char>(c);
+  return ret;
+}
+
+
+const Arithmos::Format* find_format(const std::string& name) {
+  // a format in an odd base, for the checks that depend on the parity
+  static const Arithmos::Format ternary("0t", { '0', '1', '2' },
+                                        "e", { '0', '1', '2' });
+  // formats with digit-group separators and other symbols: thousands
+  // separated by commas; the European style, with a decimal comma and
+  // thousands separated by points; and hexadecimal with the digits grouped
+  // in fours by underscores
+  typedef Arithmos::Format::Symbols Symbols;
+  static const Arithmos::Format grouped(
+                 "", Arithmos::decimal_digits, "e", Arithmos::decimal_digits,
+                 Symbols('.', '+', '-', ',', 3));
+  static const Arithmos::Format european(
+                 "", Arithmos::decimal_digits, "e", Arithmos::decimal_digits,
+                 Symbols(',', '+', '-', '.', 3));
+  static const Arithmos::Format nibbles(
+                 "0x", Arithmos::hexadecimal_digits, "p",
+                 Arithmos::hexadecimal_digits,
+                 Symbols('.', '+', '-', '_', 4));
+  // a format whose digits are limited: '2' may be used twice in a number
+  // and '1' once in its exponent
+  static const Arithmos::Format counted("0c", { '0', '1', { '2', 2 }, '3' },
+                                        "ee", { '0', { '1', 1 } });
+  if (name == "binary")
+    return &Arithmos::binary.get();
+  else if (name == "octal")
+    return &Arithmos::octal.get();
+  else if (name == "decimal")
+    return &Arithmos::decimal.get();
+  else if (name == "hexadecimal")
+    return &Arithmos::hexadecimal.get();
+  else if (name == "ternary")
+    return &ternary;
+  else if (name == "grouped")
+    return &grouped;
+  else if (name == "european")
+    return &european;
+  else if (name == "nibbles")
+    return &nibbles;
+  else if (name == "counted")
+    return &counted;
+  return nullptr;
+}
+
+bool find_rounding(const std::string& name, Arithmos::Rounding& mode) {
+  using Arithmos::Rounding;
+  static const std::pair<const char*, Rounding> modes[] = {
+    { "nearest_even", Rounding::nearest_even },
+    { "nearest_away", Rounding::nearest_away },
+    { "toward_zero", Rounding::toward_zero },
+    { "away_from_zero", Rounding::away_from_zero },
+    { "toward_positive", Rounding::toward_positive },
+    { "toward_negative", Rounding::toward_negative }
+  };
+  for (const auto& m : modes)
+    if (name == m.first) {
+      mode = m.second;
+      return true;
+    }
+  return false;
+}
+
+const Arithmos::WFormat* find_wformat(const std::string& name) {
+  if (name == "binary")
+    return &Arithmos::wbinary.get();
+  else if (name == "octal")
+    return &Arithmos::woctal.get();
+  else if (name == "decimal")
+    return &Arithmos::wdecimal.get();
+  else if (name == "hexadecimal")
+    return &Arithmos::whexadecimal.get();
+  return nullptr;
+}
+
+const Arithmos::U16Format* find_u16format(const std::string& name) {
+  if (name == "binary")
+    return &Arithmos::u16binary.get();
+  else if (name == "octal")
+    return &Arithmos::u16octal.get();
+  else if (name == "decimal")
+    return &Arithmos::u16decimal.get();
+  else if (name == "hexadecimal")
+    return &Arithmos::u16hexadecimal.get();
+  return nullptr;
+}
+
+const Arithmos::U32Format* find_u32format(const std::string& name) {
+  if (name == "binary")
+    return &Arithmos::u32binary.get();
+  else if (name == "octal")
+    return &Arithmos::u32octal.get();
+  else if (name == "decimal")
+    return &Arithmos::u32decimal.get();
+  else if (name == "hexadecimal")
+    return &Arithmos::u32hexadecimal.get();
+  return nullptr;
+}
+
+
+template <typename T>
+void print_column(const Arithmos::Column<T>& column) {
+  for (std::size_t i = 0; i < column.size(); ++i) {
+    if (column.is_valid(i))
+      std::cout << column.values[i] << ' ';
+    else
+      std::cout << "- ";
+  }
+  std::cout << ';';
+  for (auto i = column.rejected.begin(); i != column.rejected.end(); ++i)
+    std::cout << ' ' << *i;
+}
+
+
+// print what a registry generation holds under each of the names: a format
+// converts its "10" to decimal, a translation translates "0xff", and a name
+// with neither prints `-'
+void print_generation(const Arithmos::Format_Registry::Generation& g,
+                      char* first[], char* last[]) {
+  std::cout << g.number() << ':';
+  for (; first != last; ++first) {
+    const Arithmos::Format* f = g.format(*first);
+    const Arithmos::Translation* t = g.translation(*first);
+    if (f)
+      std::cout << ' ' << f->to(Arithmos::decimal, f->specifier() + "10");
+    else if (t)
+      std::cout << ' ' << Arithmos::translate<>(std::string("0xff"), *t);
+    else
+      std::cout << " -";
+  }
+}
+
+
+// print a noexcept method's status as the name of the error and position
+void print_status(const Arithmos::Status& status) {
+  static const char* const names[] = {
+    "ok", "empty", "specifier", "digit", "digit_count", "lone_point",
+    "no_digits", "no_exponent_digits", "exponent_digit",
+    "exponent_digit_count", "not_integer", "invalid_format", "not_in_set",
+    "separator", "catalog", "length_limit", "digit_limit", "exponent_limit",
+    "cost_limit"
+  };
+  std::cout << names[static_cast<int>(status.error)] << ':'
+            << status.position;
+}
+
+
 int main(int argc, char* argv[]) {
+#ifdef LIBARITHMOS_EXCEPTIONS
 try {
+#else
+{
+#endif
   using Arithmos::translate;
   using Arithmos::hex_upper_to_lower;
   using Arithmos::binary;
@@ -94,6 +272,18 @@ try {
       print_data(d);
       return 0;
     }
+    else if (number_type == "HEXADECIMAL") {
+      // as "Hexadecimal", but using the translation as a set of
+      // congruences rather than the pre-defined translation itself
+      const Arithmos::Translation& t = Arithmos::hex_upper_to_lower;
+      const Data d = hexadecimal.compare(translate<>(input, t));
+      print_data(d);
+      return 0;
+    }
+    else if (number_type == "static") {
+      std::cout << static_init_check;
+      return 0;
+    }
     else if (number_type == "custom1") {
       const Data d = custom1.compare(input);
       print_data(d);
@@ -199,6 +389,661 @@ try {
       }
       return 0;
     }
+    else if (number_type == "cache" || number_type == "cacheto") {
+      // cache:    compare each input with a cache of one shard holding two
+      //           results, printing the normalized number (or `-' if not
+      //           a number) and then the cache's counters
+      // cacheto:  likewise, but convert each input to the second format
+      const int first = number_type == "cache" ? 3 : 4;
+      if (argc < first) {
+        std::cerr << "failure: program usage incorrect.";
+        return 1;
+      }
+      const Arithmos::Format* f = find_format(argv[2]);
+      const Arithmos::Format* t = first == 4 ? find_format(argv[3]) : f;
+      if (!f || !t) {
+        std::cerr << "failure: program usage incorrect.";
+        return 1;
+      }
+      Arithmos::Cached_Format cache(*f, 2, 1);
+      for (int i = first; i < argc; ++i) {
+        if (first == 3) {
+          const Data d = cache.compare(argv[i]);
+          std::cout << (d.is_number ? d.normalized : "-") << ' ';
+        }
+        else
+          std::cout << cache.to(*t, argv[i]) << ' ';
+      }
+      const Arithmos::Cached_Format::Statistics stats = cache.statistics();
+      std::cout << stats.hits << ':' << stats.misses << ':' << stats.evictions;
+      return 0;
+    }
+    else if (number_type == "threads") {
+      // threads:  convert a number of the given length (with digits made
+      //           by a linear congruential generator) using the given
+      //           number of threads, and back; the results must be those
+      //           of one thread. Print the converted number's length and
+      //           its first and last ten characters
+      if (argc < 6) {
+        std::cerr << "failure: program usage incorrect.";
+        return 1;
+      }
+      const Arithmos::Format* f = find_format(argv[2]);
+      const Arithmos::Format* t = find_format(argv[3]);
+      if (!f || !t) {
+        std::cerr << "failure: convert number type not recognized.";
+        return 1;
+      }
+      const std::size_t length = std::stoul(argv[4]);
+      const unsigned threads = std::stoul(argv[5]);
+      const auto& digits = f->digits();
+      std::size_t base = 0;
+      while (base < digits.size() && digits[base] != f->symbols().point)
+        ++base;
+      std::string number = f->specifier();
+      unsigned long long state = 1;
+      for (std::size_t i = 0; i < length; ++i) {
+        // (the first digit is not zero)
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        number += digits[(i == 0) + (state >> 33) % (base - (i == 0))].name();
+      }
+      const std::string converted = f->to(*t, number, threads);
+      if (converted != f->to(*t, number, 1)
+          || t->to(*f, converted, threads) != number) {
+        std::cerr << "failure: threaded conversion disagrees.";
+        return 1;
+      }
+      std::cout << converted.length() << ' ' << converted.substr(0, 10)
+                << ' ' << converted.substr(converted.length() - 10);
+      return 0;
+    }
+    else if (number_type == "to") {
+      // to:  convert a number between any two of the pre-defined formats,
+      //      using the given number of threads
+      if (argc < 6) {
+        std::cerr << "failure: program usage incorrect.";
+        return 1;
+      }
+      const Arithmos::Format* f = find_format(argv[2]);
+      const Arithmos::Format* t = find_format(argv[3]);
+      if (!f || !t) {
+        std::cerr << "failure: convert number type not recognized.";
+        return 1;
+      }
+      std::cout << f->to(*t, argv[5], std::stoul(argv[4]));
+      return 0;
+    }
+    else if (number_type == "batch") {
+      // batch:  convert the numbers together, using the given number of
+      //         threads, printing each row (or `-' if null), then `;' and
+      //         the rejected rows, then `|' and the packed buffer; every
+      //         row must be what to returns for it
+      if (argc < 6) {
+        std::cerr << "failure: program usage incorrect.";
+        return 1;
+      }
+      const Arithmos::Format* f = find_format(argv[2]);
+      const Arithmos::Format* t = find_format(argv[3]);
+      if (!f || !t) {
+        std::cerr << "failure: convert number type not recognized.";
+        return 1;
+      }
+      const unsigned threads = std::stoul(argv[4]);
+      const std::vector<std::string> inputs(argv + 5, argv + argc);
+      const Arithmos::Batch batch = f->to_batch(*t, inputs, threads);
+      if (batch.size() != inputs.size()
+          || batch.offsets.back() != batch.buffer.length()) {
+        std::cerr << "failure: batch is not packed.";
+        return 1;
+      }
+      for (std::size_t i = 0; i < batch.size(); ++i) {
+        if (batch.get(i) != f->to(*t, inputs[i], threads)) {
+          std::cerr << "failure: batch and to disagree.";
+          return 1;
+        }
+        if (batch.is_valid(i))
+          std::cout << batch.get(i) << ' ';
+        else
+          std::cout << "- ";
+      }
+      std::cout << ';';
+      for (auto i = batch.rejected.begin(); i != batch.rejected.end(); ++i)
+        std::cout << ' ' << *i;
+      std::cout << " |" << batch.buffer;
+      return 0;
+    }
+    else if (number_type == "limits") {
+      // limits:  parse and convert the number within the limits (length,
+      //          digits, exponent and cost, 0 for none), printing the status
+      //          of each and then the converted number; within the limits,
+      //          the results must be those without them
+      if (argc < 9) {
+        std::cerr << "failure: program usage incorrect.";
+        return 1;
+      }
+      const Arithmos::Format* f = find_format(argv[2]);
+      const Arithmos::Format* t = find_format(argv[3]);
+      if (!f || !t) {
+        std::cerr << "failure: convert number type not recognized.";
+        return 1;
+      }
+      const Arithmos::Format::Limits limits(
+          std::stoul(argv[4]), std::stoul(argv[5]), std::stoull(argv[6]),
+          std::stoull(argv[7]));
+      Arithmos::Data data;
+      const Arithmos::Status parsed = f->parse(argv[8], data, limits);
+      std::string output;
+      const Arithmos::Status converted =
+          f->convert(*t, argv[8], output, limits);
+      if ((parsed && data != f->compare(argv[8]))
+          || (converted && output != f->to(*t, argv[8]))) {
+        std::cerr << "failure: limits changed a result.";
+        return 1;
+      }
+      print_status(parsed);
+      std::cout << ' ';
+      print_status(converted);
+      std::cout << ' ' << output;
+      return 0;
+    }
+    else if (number_type == "catalog") {
+      // catalog:  compile the formats and the hexadecimal case translations
+      //           into a catalog file, damage the file if asked (flipping
+      //           a bit of the byte at the given offset, or dropping the
+      //           last byte if `short'), then map it back in, printing the
+      //           status of validate and the names of the formats and the
+      //           translations (with the translation of a string); every
+      //           format must be the one compiled, and every translation
+      //           must agree with translate
+      if (argc < 4) {
+        std::cerr << "failure: program usage incorrect.";
+        return 1;
+      }
+      const std::string damage(argv[2]);
+      Arithmos::Catalog::format_map formats;
+      for (int i = 3; i < argc; ++i) {
+        const Arithmos::Format* f = find_format(argv[i]);
+        if (!f) {
+          std::cerr << "failure: number type not recognized.";
+          return 1;
+        }
+        formats.emplace(argv[i], *f);
+      }
+      Arithmos::Catalog::translation_map translations;
+      translations.emplace("lower_to_upper",
+                           Arithmos::hex_lower_to_upper.get());
+      translations.emplace("upper_to_lower",
+                           Arithmos::hex_upper_to_lower.get());
+      std::string block = Arithmos::Catalog::compile(formats, translations);
+      if (damage == "short")
+        block.pop_back();
+      else if (damage != "-")
+        block[std::stoul(damage)] ^= 1;
+      {
+        std::ofstream out("catalog.bin", std::ios::binary);
+        out.write(block.data(), block.size());
+      }
+
+      const Arithmos::Catalog_File file("catalog.bin");
+      const Arithmos::errc error =
+          Arithmos::Catalog::validate(file.data(), file.size());
+      print_status(Arithmos::Status{ error, 0 });
+      if (error != Arithmos::errc::ok)
+        return 0;
+      const Arithmos::Catalog catalog(file.data(), file.size());
+      if (catalog.formats() != formats.size()
+          || catalog.translations() != translations.size()
+          || catalog.find_format("none") != Arithmos::Catalog::npos
+          || catalog.translation("none") != nullptr) {
+        std::cerr << "failure: catalog has the wrong entries.";
+        return 1;
+      }
+      std::cout << ' ';
+      for (std::size_t i = 0; i < catalog.formats(); ++i) {
+        const std::string name = catalog.format_name(i);
+        const Arithmos::Format& c = catalog.format(i);
+        const Arithmos::Format& f = formats.at(name);
+        if (catalog.find_format(name) != i || catalog.format(name) != &c
+            || c.specifier() != f.specifier() || c.digits() != f.digits()
+            || c.exponent_specifier() != f.exponent_specifier()
+            || c.exponent_digits() != f.exponent_digits()
+            || c.symbols().point != f.symbols().point
+            || c.symbols().plus != f.symbols().plus
+            || c.symbols().minus != f.symbols().minus
+            || c.symbols().separator != f.symbols().separator
+            || c.symbols().group != f.symbols().group) {
+          std::cerr << "failure: catalog format differs.";
+          return 1;
+        }
+        std::cout << name << ' ';
+      }
+      std::cout << '|';
+      const std::string input("0x1aBcDeFg");
+      for (std::size_t i = 0; i < catalog.translations(); ++i) {
+        const std::string name = catalog.translation_name(i);
+        const std::string output = catalog.translate(i, input);
+        if (output != Arithmos::translate(input, translations.at(name))
+            || output != Arithmos::translate(input, catalog.translation(i))
+            || catalog.translation(name) != &catalog.translation(i)) {
+          std::cerr << "failure: catalog translation differs.";
+          return 1;
+        }
+        std::cout << ' ' << name << ' ' << output;
+      }
+      return 0;
+    }
+    else if (number_type == "into") {
+      // into:  compare and convert the numbers one after the other, into
+      //        one Basic_Data and one output string with one context,
+      //        printing the normalized number and the conversion (or `-'
+      //        if there is none) of each; every result must be what
+      //        compare and to return
+      if (argc < 5) {
+        std::cerr << "failure: program usage incorrect.";
+        return 1;
+      }
+      const Arithmos::Format* f = find_format(argv[2]);
+      const Arithmos::Format* t = find_format(argv[3]);
+      if (!f || !t) {
+        std::cerr << "failure: convert number type not recognized.";
+        return 1;
+      }
+      Arithmos::Format::Context context;
+      Arithmos::Data data;
+      std::string output;
+      for (int i = 4; i < argc; ++i) {
+        f->compare_into(argv[i], data, context);
+        f->to_into(*t, argv[i], output, context);
+        if (data != f->compare(argv[i])) {
+          std::cerr << "failure: compare_into and compare disagree.";
+          return 1;
+        }
+        if (output != f->to(*t, argv[i])) {
+          std::cerr << "failure: to_into and to disagree.";
+          return 1;
+        }
+        std::cout << (data.is_number ? data.normalized : "-") << ' '
+                  << (output.empty() ? "-" : output) << ' ';
+      }
+      return 0;
+    }
+    else if (number_type == "decode") {
+      // decode:  decode a column of numbers (separated by the given
+      //          delimiter) into int64, uint64 or double values, printing
+      //          each value (or `-' if null), then `;' and the rejected
+      //          rows
+      const Arithmos::Format* f = find_format(argv[2]);
+      if (!f || argc < 6 || std::string(argv[4]).length() != 1) {
+        std::cerr << "failure: program usage incorrect.";
+        return 1;
+      }
+      const std::string type(argv[3]);
+      const char delimiter = argv[4][0];
+      if (type == "int64")
+        print_column(f->decode<std::int64_t>(argv[5], delimiter));
+      else if (type == "uint64")
+        print_column(f->decode<std::uint64_t>(argv[5], delimiter));
+      else if (type == "double")
+        print_column(f->decode<double>(argv[5], delimiter));
+      else {
+        std::cerr << "failure: value type (" << type << ") not recognized.";
+        return 1;
+      }
+      return 0;
+    }
+    else if (number_type == "order") {
+      // order:  print the numerical order of two numbers: -1, 0 or 1
+      const Arithmos::Format* f = find_format(argv[2]);
+      if (!f || argc < 5) {
+        std::cerr << "failure: program usage incorrect.";
+        return 1;
+      }
+      const int o = f->order(argv[3], argv[4]);
+      std::cout << (o < 0 ? -1 : (o > 0 ? 1 : 0));
+      return 0;
+    }
+    else if (number_type == "sort") {
+      // sort:  sort the inputs by their sort keys and print them, checking
+      //        that sorting with Numeric_Less gives the same order
+      const Arithmos::Format* f = find_format(argv[2]);
+      if (!f) {
+        std::cerr << "failure: program usage incorrect.";
+        return 1;
+      }
+      std::vector<std::string> by_key(argv+3, argv+argc);
+      std::vector<std::string> by_less(by_key);
+      std::stable_sort(by_key.begin(), by_key.end(),
+                       [f](const std::string& a, const std::string& b) {
+                         return f->sort_key(a) < f->sort_key(b);
+                       });
+      std::stable_sort(by_less.begin(), by_less.end(),
+                       Arithmos::Numeric_Less(*f));
+      if (by_key != by_less) {
+        std::cerr << "failure: sort keys and Numeric_Less disagree.";
+        return 1;
+      }
+      for (auto i = by_key.begin(); i != by_key.end(); ++i)
+        std::cout << (i == by_key.begin() ? "" : " ") << *i;
+      return 0;
+    }
+    else if (number_type == "intern") {
+      // intern:  intern pairs of (format, number) arguments in one table,
+      //          printing the id of each (or `-' if not a number) and then
+      //          the size of the table
+      if (argc % 2 == 1) {
+        std::cerr << "failure: program usage incorrect.";
+        return 1;
+      }
+      Arithmos::Intern_Table table;
+      for (int i = 2; i < argc; i += 2) {
+        const Arithmos::Format* f = find_format(argv[i]);
+        if (!f) {
+          std::cerr << "failure: number type not recognized.";
+          return 1;
+        }
+        const Arithmos::Numeric_Value v = f->value(argv[i+1]);
+        const Arithmos::Intern_Table::id_type id = table.intern(v);
+        if (id == Arithmos::Intern_Table::npos)
+          std::cout << "- ";
+        else if (table[id].hash() != v.hash() || table[id] != v) {
+          std::cerr << "failure: interned value not equal.";
+          return 1;
+        }
+        else
+          std::cout << id << ' ';
+      }
+      std::cout << table.size();
+      return 0;
+    }
+    else if (number_type == "round" || number_type == "places") {
+      // round:   round each number to the given significant digits
+      // places:  round each number to the given fractional places
+      if (argc < 6) {
+        std::cerr << "failure: program usage incorrect.";
+        return 1;
+      }
+      const Arithmos::Format* f = find_format(argv[2]);
+      Arithmos::Rounding mode;
+      if (!f || !find_rounding(argv[3], mode)) {
+        std::cerr << "failure: number type or rounding not recognized.";
+        return 1;
+      }
+      const long long n = std::stoll(argv[4]);
+      for (int i = 5; i < argc; ++i) {
+        const std::string rounded = number_type == "round" ?
+                                      f->round(argv[i], n, mode) :
+                                      f->round_places(argv[i], n, mode);
+        if (f->compare(rounded).normalized != rounded) {
+          std::cerr << "failure: rounded number not normalized.";
+          return 1;
+        }
+        std::cout << (i == 5 ? "" : " ") << rounded;
+      }
+      return 0;
+    }
+    else if (number_type == "fraction") {
+      // fraction:  convert each number, fraction and all, with the given
+      //            places after the point at most (the integer literals
+      //            must convert as they do with to)
+      if (argc < 7) {
+        std::cerr << "failure: program usage incorrect.";
+        return 1;
+      }
+      const Arithmos::Format* f = find_format(argv[2]);
+      const Arithmos::Format* t = find_format(argv[3]);
+      Arithmos::Rounding mode;
+      if (!f || !t || !find_rounding(argv[4], mode)) {
+        std::cerr << "failure: number type or rounding not recognized.";
+        return 1;
+      }
+      const std::size_t n = std::stoul(argv[5]);
+      for (int i = 6; i < argc; ++i) {
+        const Arithmos::Data d = f->compare(argv[i]);
+        const std::string converted = f->to_places(*t, d, n, mode);
+        if ( d.is_number
+             && ((d.is_integer_literal && converted != f->to(*t, d))
+                 || t->compare(converted).normalized != converted) ) {
+          std::cerr << "failure: converted number not as to converts it.";
+          return 1;
+        }
+        std::cout << (i == 6 ? "" : " ") << converted;
+      }
+      return 0;
+    }
+    else if (number_type == "arithmetic") {
+      // arithmetic:  print the sum, difference and product of the two
+      //              numbers, the negation of the first and its sign (the
+      //              *_into forms, with one context and the output being
+      //              the first operand, must agree), then the running total
+      //              of all the numbers
+      if (argc < 5) {
+        std::cerr << "failure: program usage incorrect.";
+        return 1;
+      }
+      const Arithmos::Format* f = find_format(argv[2]);
+      if (!f) {
+        std::cerr << "failure: number type not recognized.";
+        return 1;
+      }
+      const std::string a(argv[3]), b(argv[4]);
+      const std::string results[] = { f->add(a, b), f->subtract(a, b),
+                                      f->multiply(a, b), f->negate(a) };
+      Arithmos::Format::Context context;
+      std::string into[] = { a, a, a, a };
+      f->add_into(into[0], b, into[0], context);
+      f->subtract_into(into[1], b, into[1], context);
+      f->multiply_into(into[2], b, into[2], context);
+      f->negate_into(into[3], into[3], context);
+      for (int i = 0; i < 4; ++i) {
+        if (into[i] != results[i]) {
+          std::cerr << "failure: arithmetic into a string disagrees.";
+          return 1;
+        }
+        std::cout << results[i] << ' ';
+      }
+      std::cout << f->sign(a);
+      std::string total = argv[3];
+      for (int i = 4; i < argc; ++i)
+        f->add_into(total, argv[i], total, context);
+      std::cout << ' ' << total;
+      return 0;
+    }
+    else if (number_type == "pattern") {
+      // pattern:  with no numbers, print the format's patterns, whether
+      //           they are exact, and the automaton's size; otherwise
+      //           print 1 for each number and 0 for each string that is
+      //           not (the patterns, the automaton and the automaton read
+      //           back from its serialization must agree with compare
+      //           where they are exact, and accept every number anyway)
+      const Arithmos::Format* f = input == "custom1" ? &custom1
+                                                     : find_format(input);
+      if (!f) {
+        std::cerr << "failure: number type not recognized.";
+        return 1;
+      }
+      const std::string ecmascript = f->pattern();
+      const std::string posix = f->pattern(Arithmos::Syntax::posix);
+      const Arithmos::Byte_Automaton a = f->automaton();
+      Arithmos::Byte_Automaton b;
+      if (!Arithmos::Byte_Automaton::deserialize(a.serialize(), b)
+          || b.serialize() != a.serialize()) {
+        std::cerr << "failure: automaton not read back as written.";
+        return 1;
+      }
+      if (argc == 3) {
+        std::cout << ecmascript << '\n' << posix << '\n'
+                  << f->pattern_exact() << ' ' << a.exact << ' '
+                  << a.accepting.size() << ' ' << a.class_count;
+        return 0;
+      }
+      const std::regex regexes[] = {
+        std::regex(ecmascript),
+        std::regex(posix, std::regex::extended)
+      };
+      for (int i = 3; i < argc; ++i) {
+        const bool number = f->compare(argv[i]).is_number;
+        for (const auto& r : regexes) {
+          const bool match = std::regex_search(argv[i], r);
+          if (match != number && (f->pattern_exact() || number)) {
+            std::cerr << "failure: pattern and compare disagree.";
+            return 1;
+          }
+        }
+        for (const Arithmos::Byte_Automaton& c : { a, b }) {
+          const bool match = c.matches(argv[i]);
+          if (match != number && (c.exact || number)) {
+            std::cerr << "failure: automaton and compare disagree.";
+            return 1;
+          }
+        }
+        std::cout << (i == 3 ? "" : " ") << number;
+      }
+      return 0;
+    }
+    else if (number_type == "truncate") {
+      // truncate:  truncate each number to an integer
+      const Arithmos::Format* f = find_format(argv[2]);
+      if (!f) {
+        std::cerr << "failure: number type not recognized.";
+        return 1;
+      }
+      for (int i = 3; i < argc; ++i)
+        std::cout << (i == 3 ? "" : " ") << f->truncate(argv[i]);
+      return 0;
+    }
+    else if (number_type == "parse") {
+      // parse:  parse the number, printing the status and then the data
+      //         (which must be what compare returns)
+      if (argc < 4) {
+        std::cerr << "failure: program usage incorrect.";
+        return 1;
+      }
+      const Arithmos::Format* f = find_format(argv[2]);
+      if (!f) {
+        std::cerr << "failure: number type not recognized.";
+        return 1;
+      }
+      Arithmos::Data d;
+      const Arithmos::Status status = f->parse(argv[3], d);
+      if (static_cast<bool>(status) != d.is_number
+          || d.normalized != f->compare(argv[3]).normalized) {
+        std::cerr << "failure: parse and compare disagree.";
+        return 1;
+      }
+      print_status(status);
+      std::cout << ' ';
+      print_data(d);
+      return 0;
+    }
+    else if (number_type == "tryconvert") {
+      // tryconvert:  convert the number, printing the status and then the
+      //              converted number
+      if (argc < 5) {
+        std::cerr << "failure: program usage incorrect.";
+        return 1;
+      }
+      const Arithmos::Format* f = find_format(argv[2]);
+      const Arithmos::Format* t = find_format(argv[3]);
+      if (!f || !t) {
+        std::cerr << "failure: convert number type not recognized.";
+        return 1;
+      }
+      std::string output;
+      print_status(f->convert(*t, argv[4], output));
+      std::cout << ' ' << output;
+      return 0;
+    }
+    else if (number_type == "push") {
+      // push:  feed the chunks to a push parser, printing the state after
+      //        each (v, c or x for viable, complete or invalid) and then the
+      //        final data; every prefix is also checked against compare
+      if (argc < 4) {
+        std::cerr << "failure: program usage incorrect.";
+        return 1;
+      }
+      const Arithmos::Format* f = find_format(argv[2]);
+      if (!f) {
+        std::cerr << "failure: number type not recognized.";
+        return 1;
+      }
+      Arithmos::Push_Parser parser(*f);
+      Arithmos::Push_Parser checker(*f);
+      for (int i = 3; i < argc; ++i) {
+        for (const char* c = argv[i]; *c; ++c) {
+          const Arithmos::Parse_State state = checker.feed(*c);
+          if (state != Arithmos::Parse_State::invalid
+              && (state == Arithmos::Parse_State::complete)
+                 != f->compare(checker.input()).is_number) {
+            std::cerr << "failure: push parser and compare disagree.";
+            return 1;
+          }
+        }
+        const Arithmos::Parse_State state = parser.feed(argv[i]);
+        std::cout << (state == Arithmos::Parse_State::viable ? 'v' :
+                      state == Arithmos::Parse_State::complete ? 'c' : 'x')
+                  << ' ';
+      }
+      print_data(parser.finish());
+      return 0;
+    }
+    else if (number_type == "registry") {
+      // registry:  publish the predefined formats (and an "upper"
+      //            translation) in a registry, and then, while a Reader
+      //            holds that generation, publish one with only "decimal"
+      //            from another thread; print the names' lookups in the
+      //            new generation and then again in the held one
+      Arithmos::Format_Registry registry(4);
+      registry.publish(
+          { { "binary", Arithmos::binary.get() },
+            { "octal", Arithmos::octal.get() },
+            { "decimal", Arithmos::decimal.get() },
+            { "hexadecimal", Arithmos::hexadecimal.get() } },
+          { { "upper", Arithmos::hex_lower_to_upper.get() } });
+      std::thread writer;
+      {
+        const Arithmos::Format_Registry::Reader held = registry.read();
+        writer = std::thread([&registry]() {
+          registry.publish({ { "decimal", Arithmos::decimal.get() } });
+        });
+        while (registry.read()->number() == held->number())
+          std::this_thread::yield();
+        print_generation(*registry.read(), argv + 2, argv + argc);
+        std::cout << ' ';
+        print_generation(*held, argv + 2, argv + argc);
+      }
+      writer.join();
+      return 0;
+    }
+    else if (number_type == "wconvert" || number_type == "u16convert") {
+      // wconvert:    convert a wchar_t number into a char number
+      // u16convert:  convert a char16_t number into a char32_t number
+      if (argc < 5) {
+        std::cerr << "failure: program usage incorrect.";
+        return 1;
+      }
+      const std::string from(argv[2]);
+      const std::string to(argv[3]);
+      const std::string input(argv[4]);
+      if (number_type == "wconvert") {
+        const Arithmos::WFormat* f = find_wformat(from);
+        const Arithmos::Format* t = find_format(to);
+        if (!f || !t) {
+          std::cerr << "failure: convert number type not recognized.";
+          return 1;
+        }
+        std::cout << f->to(*t, widen<wchar_t>(input));
+      }
+      else {
+        const Arithmos::U16Format* f = find_u16format(from);
+        const Arithmos::U32Format* t = find_u32format(to);
+        if (!f || !t) {
+          std::cerr << "failure: convert number type not recognized.";
+          return 1;
+        }
+        std::cout << narrow(f->to(*t, widen<char16_t>(input)));
+      }
+      return 0;
+    }
     else {
       std::cerr << "failure: number type (" << number_type
                 << ") not recognized.";
@@ -209,7 +1054,11 @@ try {
   std::cerr << "failure: unexpected execution path.";
   return 2;
 
-} catch (std::exception& exc) {
+}
+#ifdef LIBARITHMOS_EXCEPTIONS
+catch (std::exception& exc) {
   std::cerr << "failure: caught exception: " << exc.what();
   return 2;
-}}
+}
+#endif
+}